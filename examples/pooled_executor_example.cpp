@@ -0,0 +1,49 @@
+/**
+ * Example illustrating tasks borrowing scratch buffers from a pool instead
+ * of acquiring them by hand in every worker loop.
+ * 
+ * Usage:
+ * ./build/examples/pooled_executor_example
+ * 
+ * Expected output:
+ * 
+ * ```
+ * Ran 100 tasks with 2 scratch buffers.
+ * ```
+ */
+#include <iostream>
+#include <vector>
+#include "pooled_executor.hpp"
+
+using namespace std;
+using namespace carlosb;
+
+struct scratch
+{
+    scratch()
+        : buffer(4096)
+    {}
+
+    vector<char> buffer;    // expensive to allocate, cheap to reuse
+};
+
+int main()
+{
+    object_pool<scratch> buffers(2);    // one buffer per worker
+
+    {
+        pooled_executor<scratch> executor(buffers, 2);
+
+        for (int i = 0; i < 100; ++i)
+        {
+            executor.submit([i] (scratch& s)
+            {
+                s.buffer[0] = static_cast<char>(i);
+            });
+        }
+    }   // waits for every task
+
+    cout << "Ran 100 tasks with " << buffers.capacity() << " scratch buffers.\n";
+
+    return 0;
+}
@@ -0,0 +1,182 @@
+/*
+ *  Copyright 2017 Carlos David Brito Pacheco
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ * 
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ * 
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef CARLOSB_BACKGROUND_RECLAIMER_HPP
+#define CARLOSB_BACKGROUND_RECLAIMER_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace carlosb
+{
+    /**
+     * @brief      Runs tasks on a dedicated background thread.
+     *
+     * Meant to be given to `object_pool::set_reclaimer()` so that surplus
+     * objects are destroyed outside of the threads using the pool. Tasks are
+     * run in the order they were submitted. The destructor runs every
+     * pending task before joining the thread.
+     */
+    class background_reclaimer
+    {
+    public:
+        using task_type     = std::function<void()>;                ///< Type of the tasks.
+        using executor_type = std::function<void(task_type)>;       ///< Type of the executor handed to pools.
+
+        /**
+         * @brief      Starts the background thread.
+         */
+        background_reclaimer()
+            : m_state(std::make_shared<state>())
+        {
+            std::shared_ptr<state> st = m_state;
+            m_thread = std::thread([st] (void) { st->run(); });
+        }
+
+        background_reclaimer(const background_reclaimer&) = delete;
+        background_reclaimer& operator=(const background_reclaimer&) = delete;
+
+        /**
+         * @brief      Runs the pending tasks and joins the background thread.
+         */
+        ~background_reclaimer()
+        {
+            m_state->stop();
+            m_thread.join();
+        }
+
+        /**
+         * @brief      Queues a task to be run on the background thread.
+         *
+         * @param[in]  task  Task to be run.
+         *
+         * If the reclaimer has been stopped the task is run immediately by
+         * the calling thread.
+         */
+        void submit(task_type task)
+        {
+            m_state->submit(std::move(task));
+        }
+
+        /**
+         * @brief      Returns an executor which submits tasks to `*this`.
+         *
+         * @return     The executor. It may outlive `*this`, in which case
+         * it runs tasks on the calling thread.
+         */
+        executor_type executor() const
+        {
+            std::shared_ptr<state> st = m_state;
+            return [st] (task_type task) { st->submit(std::move(task)); };
+        }
+
+        /**
+         * @brief      Blocks until every task submitted so far has been run.
+         */
+        void wait_idle()
+        {
+            m_state->wait_idle();
+        }
+
+    private:
+        struct state
+        {
+            state()
+                :   pending(0),
+                    stopped(false)
+            {}
+
+            void submit(task_type task)
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                if (stopped)
+                {
+                    lock.unlock();
+                    task();
+                    return;
+                }
+                tasks.push_back(std::move(task));
+                ++pending;
+                lock.unlock();
+                task_available.notify_one();
+            }
+
+            void run()
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                for (;;)
+                {
+                    task_available.wait(lock, [this] (void) { return stopped || !tasks.empty(); });
+                    if (tasks.empty())
+                        return;
+
+                    task_type task = std::move(tasks.front());
+                    tasks.pop_front();
+                    lock.unlock();
+                    task();
+                    task = nullptr;
+                    lock.lock();
+
+                    if (--pending == 0)
+                        idle.notify_all();
+                }
+            }
+
+            void stop()
+            {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    stopped = true;
+                }
+                task_available.notify_one();
+            }
+
+            void wait_idle()
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                idle.wait(lock, [this] (void) { return pending == 0; });
+            }
+
+            std::mutex                  mutex;
+            std::condition_variable     task_available;
+            std::condition_variable     idle;
+            std::deque<task_type>       tasks;
+            std::size_t                 pending;
+            bool                        stopped;
+        };
+
+        std::shared_ptr<state>      m_state;    ///< State shared with the thread and the executors.
+        std::thread                 m_thread;   ///< Background thread.
+    };
+}
+#endif
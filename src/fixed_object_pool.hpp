@@ -0,0 +1,353 @@
+/*
+ *  Copyright 2017 Carlos David Brito Pacheco
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ * 
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ * 
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef CARLOSB_FIXED_OBJECT_POOL_HPP
+#define CARLOSB_FIXED_OBJECT_POOL_HPP
+
+#include "mpmc_ring.hpp"
+
+#include <thread>
+
+namespace carlosb
+{
+    /**
+     * @brief      Pool of a fixed number of objects whose free list is a
+     * lock-free ring.
+     *
+     * All objects are constructed with the pool and live in a single block.
+     * Acquiring and releasing an object each take one CAS on the ring and
+     * never block, so the pool suits hot paths shared by many threads.
+     * Objects are recycled in FIFO order, which spreads the use evenly over
+     * them, e.g. over the connections of a connection pool.
+     *
+     * Unlike with `object_pool`, acquired objects do not share ownership
+     * of the pool, so that acquiring and releasing touch no reference
+     * count: every acquired object must be released before the last copy
+     * of the pool is destroyed. Builds without `NDEBUG` count the acquired
+     * objects and assert that none is left when the pool is destroyed.
+     *
+     * @tparam     T          Type of the objects.
+     * @tparam     Allocator  Allocator of the block of objects.
+     */
+    template <
+        class _Tp,
+        class _Allocator = std::allocator<_Tp>
+    >
+    class fixed_object_pool
+    {
+        static_assert(type_traits::is_allocator<_Allocator>::value,
+                      "Allocator template parameter must satisfy the BasicAllocator requirement.");
+    private:
+        class impl;     ///< Contains the actual implementation of `fixed_object_pool`.
+
+    public:
+        class acquired_object;
+
+        using value_type        = _Tp;                  ///< Type managed by the pool.
+        using acquired_type     = acquired_object;      ///< Type of acquired objects.
+        using size_type         = std::size_t;          ///< Size type used.
+        using allocator_type    = _Allocator;           ///< Type of allocator.
+
+        /**
+         * @brief      Constructs a pool of `count` default-inserted objects.
+         *
+         * @param[in]  count  Number of objects.
+         * @param[in]  alloc  Allocator to be used.
+         */
+        explicit
+        fixed_object_pool(size_type count, const _Allocator& alloc = _Allocator())
+            : m_pool(std::make_shared<impl>(count, alloc))
+        {
+            m_pool->construct();
+        }
+
+        /**
+         * @brief      Constructs a pool with `count` copies of `value`.
+         *
+         * @param[in]  count  Number of objects.
+         * @param[in]  value  Value to be copied.
+         * @param[in]  alloc  Allocator to be used.
+         */
+        fixed_object_pool(size_type count, const _Tp& value, const _Allocator& alloc = _Allocator())
+            : m_pool(std::make_shared<impl>(count, alloc))
+        {
+            m_pool->construct(value);
+        }
+
+        /**
+         * @brief      Acquires an object from the pool.
+         *
+         * @return     Acquired object, which is empty if every object is in
+         * use.
+         *
+         * Complexity
+         * ----------
+         * Constant, lock-free.
+         */
+        acquired_type acquire()
+        {
+            _Tp* obj;
+            if (!m_pool->m_free_objects.try_pop(obj))
+                return acquired_object(none);
+#ifndef NDEBUG
+            m_pool->m_outstanding.fetch_add(1, std::memory_order_relaxed);
+#endif
+            return acquired_object(obj, m_pool.get());
+        }
+
+        /**
+         * @brief      Returns the number of free objects. The result may be
+         * stale if the pool is used concurrently.
+         */
+        size_type size() const
+        {
+            return m_pool->m_free_objects.size_approx();
+        }
+
+        /**
+         * @brief      Returns the number of objects of the pool.
+         */
+        size_type capacity() const
+        {
+            return m_pool->m_count;
+        }
+
+        /**
+         * @brief      Checks if every object is in use.
+         */
+        bool empty() const
+        {
+            return size() == 0;
+        }
+
+        /**
+         * @brief      Checks if any object is in use.
+         */
+        bool in_use() const
+        {
+            return size() < capacity();
+        }
+
+    private:
+        std::shared_ptr<impl>       m_pool;                ///< Pointer to implementation of pool.
+    };
+
+    template <class _Tp, class _Allocator>
+    class fixed_object_pool<_Tp, _Allocator>::impl
+    {
+        using layout_type = detail::slot_layout<_Tp, _Allocator>;
+
+    public:
+        impl(size_type count, const _Allocator& alloc)
+            :   m_count(count),
+                m_constructed(0),
+                m_allocator(alloc),
+                m_length(block_length(count)),
+                m_block(m_allocator.allocate(m_length)),
+                m_first(detail::align_up(reinterpret_cast<std::uintptr_t>(m_block), layout_type::alignment)),
+                m_free_objects(count > 0 ? count : 1)
+        {
+#ifndef NDEBUG
+            m_outstanding.store(0, std::memory_order_relaxed);
+#endif
+        }
+
+        impl(const impl&) = delete;
+        impl& operator=(const impl&) = delete;
+
+        ~impl()
+        {
+#ifndef NDEBUG
+            assert(m_outstanding.load(std::memory_order_relaxed) == 0 && "fixed_object_pool destroyed with objects in use");
+#endif
+            for (size_type i = 0; i < m_constructed; ++i)
+                this->slot(i)->~_Tp();
+            m_allocator.deallocate(m_block, m_length);
+        }
+
+        template <class... Args>
+        void construct(const Args&... args)
+        {
+            for (; m_constructed < m_count; ++m_constructed)
+            {
+                _Tp* obj = ::new((void *) this->slot(m_constructed)) _Tp(args...);
+                m_free_objects.try_push(obj);
+            }
+        }
+
+        void return_object(_Tp* obj)
+        {
+            // the ring has room for every object, so a failed push only
+            // means a pop of the same cell has not been published yet
+            while (!m_free_objects.try_push(obj))
+                std::this_thread::yield();
+#ifndef NDEBUG
+            m_outstanding.fetch_sub(1, std::memory_order_relaxed);
+#endif
+        }
+
+        size_type                   m_count;                ///< Number of objects.
+        size_type                   m_constructed;          ///< Number of objects constructed so far.
+        _Allocator                  m_allocator;            ///< Allocates the block of objects.
+        size_type                   m_length;               ///< Number of `T` requested to the allocator.
+        _Tp*                        m_block;                ///< Storage of the objects.
+        std::uintptr_t              m_first;                ///< Address of the first slot.
+        mpmc_ring<_Tp*>             m_free_objects;         ///< Free objects, in the order they were released.
+#ifndef NDEBUG
+        std::atomic<size_type>      m_outstanding;          ///< Number of acquired objects.
+#endif
+
+    private:
+        /**
+         * Number of `T` to request so that `count` slots laid out as in
+         * `object_pool` fit in the block.
+         */
+        static size_type block_length(size_type count)
+        {
+            size_type bytes = (count > 0 ? count : 1) * layout_type::stride;
+            if (layout_type::guaranteed < layout_type::alignment)
+                bytes += layout_type::alignment - layout_type::guaranteed;
+            return (bytes + sizeof(_Tp) - 1) / sizeof(_Tp);
+        }
+
+        _Tp* slot(size_type i) const
+        {
+            return reinterpret_cast<_Tp*>(m_first + i * layout_type::stride);
+        }
+    };
+
+    template <class _Tp, class _Allocator>
+    class fixed_object_pool<_Tp, _Allocator>::acquired_object
+    {
+    public:
+        acquired_object()
+            :   m_obj(nullptr),
+                m_pool(nullptr)
+        {}
+
+        acquired_object(none_t)
+            :   m_obj(nullptr),
+                m_pool(nullptr)
+        {}
+
+        acquired_object(std::nullptr_t)
+            :   m_obj(nullptr),
+                m_pool(nullptr)
+        {}
+
+        explicit
+        acquired_object(_Tp* obj, impl* lender)
+            :   m_obj(obj),
+                m_pool(lender)
+        {
+            assert(obj && lender);
+        }
+
+        acquired_object(acquired_object&& other)
+            :   m_obj(other.m_obj),
+                m_pool(other.m_pool)
+        {
+            other.m_obj = nullptr;
+            other.m_pool = nullptr;
+        }
+
+        acquired_object(const acquired_object&) = delete;
+        acquired_object& operator=(const acquired_object&) = delete;
+
+        acquired_object& operator=(acquired_object&& other)
+        {
+            this->release();
+
+            m_obj = other.m_obj;
+            m_pool = other.m_pool;
+            other.m_obj = nullptr;
+            other.m_pool = nullptr;
+
+            return *this;
+        }
+
+        acquired_object& operator=(none_t)
+        {
+            this->release();
+            return *this;
+        }
+
+        ~acquired_object()
+        {
+            this->release();
+        }
+
+        _Tp& operator*()
+        {
+            if (!m_obj)
+                throw std::logic_error("acquired_object::operator*(): Initialization is required for data access.");
+            else
+                return *m_obj;
+        }
+
+        _Tp* operator->()
+        {
+            if (!m_obj)
+                throw std::logic_error("acquired_object::operator->(): Initialization is required for data access.");
+            else
+                return m_obj;
+        }
+
+        bool operator==(const none_t) const
+        {
+            return m_obj == nullptr;
+        }
+
+        bool operator!=(const none_t) const
+        {
+            return !(*this == none);
+        }
+
+        explicit
+        operator bool() const
+        {
+            return m_obj != nullptr;
+        }
+
+    private:
+        void release()
+        {
+            if (m_obj)
+                m_pool->return_object(m_obj);
+
+            m_obj = nullptr;
+            m_pool = nullptr;
+        }
+
+        _Tp*                        m_obj;
+        impl*                       m_pool;     ///< Lender, which outlives the object by contract.
+    };
+}
+
+#endif
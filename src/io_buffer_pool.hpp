@@ -0,0 +1,427 @@
+/*
+ *  Copyright 2017 Carlos David Brito Pacheco
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ * 
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ * 
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef CARLOSB_IO_BUFFER_POOL_HPP
+#define CARLOSB_IO_BUFFER_POOL_HPP
+
+#include "object_pool.hpp"
+
+#include <system_error>
+#include <sys/uio.h>
+
+#if defined(__has_include)
+#   if __has_include(<liburing.h>)
+#       include <liburing.h>
+#       define CARLOSB_HAS_LIBURING 1
+#   endif
+#endif
+
+namespace carlosb
+{
+    constexpr std::size_t io_page_size = 4096;     ///< Alignment of the buffers of an `io_buffer_pool`.
+
+    /**
+     * @brief      Buffer lent by an `io_buffer_pool`.
+     */
+    class io_buffer
+    {
+    public:
+        io_buffer(unsigned char* data, std::size_t size, unsigned index, std::shared_ptr<void> region)
+            :   m_data(data),
+                m_size(size),
+                m_index(index),
+                m_region(std::move(region))
+        {}
+
+        unsigned char* data() const     { return m_data; }      ///< Start of the buffer, page aligned.
+        std::size_t size() const        { return m_size; }      ///< Size of the buffer, in bytes.
+
+        /**
+         * @brief      Returns the index of the buffer among the registered
+         * buffers, as expected by `READ_FIXED` and `WRITE_FIXED`.
+         */
+        unsigned index() const          { return m_index; }
+
+    private:
+        unsigned char*          m_data;
+        std::size_t             m_size;
+        unsigned                m_index;
+        std::shared_ptr<void>   m_region;   ///< Keeps the memory alive while the buffer exists.
+    };
+
+    /**
+     * @brief      Buffers of an `io_buffer_pool` holding one message, ready
+     * for vectored I/O.
+     *
+     * The chain owns the leases of its buffers and releases them all when
+     * it is destroyed or assigned `none`.
+     */
+    class buffer_chain
+    {
+    public:
+        using acquired_type     = object_pool<io_buffer>::acquired_type;   ///< Type of the leases.
+        using size_type         = std::size_t;                             ///< Size type used.
+
+        buffer_chain()
+            : m_size(0)
+        {}
+
+        buffer_chain(none_t)
+            : m_size(0)
+        {}
+
+        buffer_chain(std::vector<acquired_type>&& leases, size_type total_bytes)
+            :   m_leases(std::move(leases)),
+                m_size(total_bytes)
+        {
+            m_iovecs.reserve(m_leases.size());
+            for (acquired_type& lease : m_leases)
+            {
+                size_type length = total_bytes < lease->size() ? total_bytes : lease->size();
+                m_iovecs.push_back(iovec{lease->data(), length});
+                total_bytes -= length;
+            }
+        }
+
+        buffer_chain(buffer_chain&&) = default;
+        buffer_chain& operator=(buffer_chain&&) = default;
+
+        /**
+         * @brief      Releases every buffer of the chain.
+         */
+        buffer_chain& operator=(none_t)
+        {
+            m_iovecs.clear();
+            m_leases.clear();
+            m_size = 0;
+            return *this;
+        }
+
+        /**
+         * @brief      Returns the `iovec` array describing the chain, to be
+         * passed to `readv`, `writev` or `sendmsg`. The last buffer is
+         * described up to the size of the chain only.
+         */
+        const iovec* iov() const
+        {
+            return m_iovecs.data();
+        }
+
+        /**
+         * @brief      Returns the number of buffers, i.e. of `iovec`s.
+         */
+        int iovcnt() const
+        {
+            return static_cast<int>(m_iovecs.size());
+        }
+
+        /**
+         * @brief      Returns the number of bytes the chain holds.
+         */
+        size_type size() const
+        {
+            return m_size;
+        }
+
+        /**
+         * @brief      Returns the lease of the buffer at `pos`.
+         *
+         * @param[in]  pos   Position of the buffer in the chain.
+         */
+        acquired_type& operator[](size_type pos)
+        {
+            return m_leases[pos];
+        }
+
+        bool operator==(const none_t) const
+        {
+            return m_leases.empty();
+        }
+
+        bool operator!=(const none_t) const
+        {
+            return !(*this == none);
+        }
+
+        explicit
+        operator bool() const
+        {
+            return !m_leases.empty();
+        }
+
+    private:
+        std::vector<acquired_type>  m_leases;               ///< Leases of the buffers.
+        std::vector<iovec>          m_iovecs;               ///< Description of the buffers.
+        size_type                   m_size;                 ///< Number of bytes of the chain.
+    };
+
+    /**
+     * @brief      Pool of page-aligned I/O buffers carved from one region,
+     * which can be registered with an io_uring instance.
+     *
+     * Registered buffers are pinned by the kernel once, instead of on every
+     * I/O. Leases are the `acquired_object`s of an `object_pool<io_buffer>`
+     * and carry the index of their buffer for `READ_FIXED`/`WRITE_FIXED`.
+     *
+     * A lease can be parked in the pool while an operation on its buffer is
+     * in flight: `park()` returns a token to be used as the `user_data` of
+     * the submission, and `complete()` releases the lease when the
+     * completion with that token is reaped.
+     *
+     * The registration helpers are only available when `<liburing.h>` is.
+     * Otherwise `iovecs()` describes the buffers for registration by other
+     * means.
+     */
+    class io_buffer_pool
+    {
+    public:
+        using pool_type         = object_pool<io_buffer>;              ///< Type of the pool of buffers.
+        using acquired_type     = pool_type::acquired_type;            ///< Type of acquired buffers.
+        using size_type         = std::size_t;                         ///< Size type used.
+        using token_type        = std::uint64_t;                       ///< Identifies a parked lease.
+
+        /**
+         * @brief      Constructs a pool of `count` buffers of at least
+         * `buffer_size` bytes.
+         *
+         * @param[in]  count        Number of buffers.
+         * @param[in]  buffer_size  Size of each buffer. It is rounded up to
+         * a multiple of the page size.
+         */
+        io_buffer_pool(size_type count, size_type buffer_size)
+            :   m_buffer_size(detail::align_up(buffer_size > 0 ? buffer_size : 1, io_page_size)),
+                m_inflight(count)
+        {
+            typedef cache_aligned_allocator<unsigned char, io_page_size> region_allocator;
+
+            size_type length = count * m_buffer_size;
+            unsigned char* data = region_allocator().allocate(length > 0 ? length : 1);
+            std::shared_ptr<void> region(data, [length] (void* ptr)
+            {
+                region_allocator().deallocate(static_cast<unsigned char*>(ptr), length);
+            });
+
+            m_iovecs.reserve(count);
+            m_buffers.reserve(count);
+            for (size_type i = 0; i < count; ++i)
+            {
+                unsigned char* buffer = data + i * m_buffer_size;
+                m_iovecs.push_back(iovec{buffer, m_buffer_size});
+                m_buffers.emplace(buffer, m_buffer_size, static_cast<unsigned>(i), region);
+            }
+        }
+
+        io_buffer_pool(const io_buffer_pool&) = delete;
+        io_buffer_pool& operator=(const io_buffer_pool&) = delete;
+
+        /**
+         * @brief      Acquires a buffer.
+         *
+         * @return     Acquired buffer, which is empty if every buffer is in
+         * use.
+         */
+        acquired_type acquire()
+        {
+            return m_buffers.acquire();
+        }
+
+        /**
+         * @brief      Waits until a buffer has been acquired or the
+         * `time_limit` has ran out.
+         *
+         * @param[in]  time_limit  Maximum waiting time, zero meaning no limit.
+         *
+         * @return     Acquired buffer.
+         */
+        acquired_type acquire_wait(std::chrono::milliseconds time_limit = std::chrono::milliseconds::zero())
+        {
+            return m_buffers.acquire_wait(time_limit);
+        }
+
+        /**
+         * @brief      Acquires enough buffers to hold `total_bytes` bytes.
+         *
+         * @param[in]  total_bytes  Size of the message.
+         *
+         * @return     Chain of buffers, which is empty if there are not
+         * enough free buffers. No buffer is taken in that case.
+         *
+         * The buffers are taken under a single lock of the pool.
+         *
+         * Complexity
+         * ----------
+         * Linear in the number of buffers of the chain.
+         */
+        buffer_chain acquire_chain(size_type total_bytes)
+        {
+            size_type count = (total_bytes + m_buffer_size - 1) / m_buffer_size;
+            if (count == 0)
+                return buffer_chain(none);
+
+            std::vector<acquired_type> leases = m_buffers.acquire_many(count);
+            if (leases.empty())
+                return buffer_chain(none);
+            return buffer_chain(std::move(leases), total_bytes);
+        }
+
+        /**
+         * @brief      Keeps `lease` in the pool until `complete()` is called
+         * with the returned token.
+         *
+         * @param[in]  lease  Lease of a buffer of this pool.
+         *
+         * @throws     std::invalid_argument if `lease` is empty or comes from
+         * another pool.
+         *
+         * @return     Token identifying the lease, e.g. the `user_data` of
+         * the submission using the buffer.
+         */
+        token_type park(acquired_type&& lease)
+        {
+            if (!lease)
+                throw std::invalid_argument("io_buffer_pool::park(): Lease is empty.");
+
+            unsigned index = lease->index();
+            if (index >= m_iovecs.size() || m_iovecs[index].iov_base != lease->data())
+                throw std::invalid_argument("io_buffer_pool::park(): Lease does not belong to this pool.");
+
+            m_inflight[index] = std::move(lease);
+            return index;
+        }
+
+        /**
+         * @brief      Releases the lease parked under `token`.
+         *
+         * @param[in]  token  Token returned by `park()`.
+         */
+        void complete(token_type token)
+        {
+            m_inflight.at(static_cast<size_type>(token)) = none;
+        }
+
+        /**
+         * @brief      Returns one `iovec` per buffer, in index order.
+         */
+        const std::vector<iovec>& iovecs() const
+        {
+            return m_iovecs;
+        }
+
+#ifdef CARLOSB_HAS_LIBURING
+        /**
+         * @brief      Registers the buffers with `ring`.
+         *
+         * @param      ring  The ring.
+         *
+         * @throws     std::system_error if the registration fails.
+         */
+        void register_buffers(io_uring& ring)
+        {
+            int ret = io_uring_register_buffers(&ring, m_iovecs.data(), static_cast<unsigned>(m_iovecs.size()));
+            if (ret < 0)
+                throw std::system_error(-ret, std::system_category(), "io_uring_register_buffers");
+        }
+
+        /**
+         * @brief      Unregisters the buffers from `ring`.
+         *
+         * @param      ring  The ring.
+         */
+        void unregister_buffers(io_uring& ring)
+        {
+            io_uring_unregister_buffers(&ring);
+        }
+
+        /**
+         * @brief      Prepares a `READ_FIXED` into the buffer of `lease`.
+         *
+         * @param      sqe     The submission.
+         * @param[in]  fd      File to read from.
+         * @param      lease   Lease of the buffer.
+         * @param[in]  offset  Offset in the file.
+         */
+        static void prep_read_fixed(io_uring_sqe* sqe, int fd, acquired_type& lease, std::uint64_t offset)
+        {
+            io_uring_prep_read_fixed(sqe, fd, lease->data(), static_cast<unsigned>(lease->size()), offset, static_cast<int>(lease->index()));
+        }
+
+        /**
+         * @brief      Prepares a `WRITE_FIXED` from the buffer of `lease`.
+         *
+         * @param      sqe     The submission.
+         * @param[in]  fd      File to write to.
+         * @param      lease   Lease of the buffer.
+         * @param[in]  nbytes  Number of bytes to write.
+         * @param[in]  offset  Offset in the file.
+         *
+         * @throws     std::invalid_argument if `nbytes` exceeds the size of
+         * the buffer.
+         */
+        static void prep_write_fixed(io_uring_sqe* sqe, int fd, acquired_type& lease, size_type nbytes, std::uint64_t offset)
+        {
+            if (nbytes > lease->size())
+                throw std::invalid_argument("io_buffer_pool::prep_write_fixed(): Write is larger than the buffer.");
+
+            io_uring_prep_write_fixed(sqe, fd, lease->data(), static_cast<unsigned>(nbytes), offset, static_cast<int>(lease->index()));
+        }
+#endif
+
+        /**
+         * @brief      Returns the size of each buffer.
+         */
+        size_type buffer_size() const
+        {
+            return m_buffer_size;
+        }
+
+        /**
+         * @brief      Returns the number of free buffers.
+         */
+        size_type size() const
+        {
+            return m_buffers.size();
+        }
+
+        /**
+         * @brief      Returns the number of buffers.
+         */
+        size_type capacity() const
+        {
+            return m_iovecs.size();
+        }
+
+    private:
+        size_type                   m_buffer_size;          ///< Size of each buffer.
+        pool_type                   m_buffers;              ///< Descriptors of the buffers.
+        std::vector<iovec>          m_iovecs;               ///< Buffers, for registration.
+        std::vector<acquired_type>  m_inflight;             ///< Parked leases, by buffer index.
+    };
+}
+
+#endif
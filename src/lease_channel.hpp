@@ -0,0 +1,302 @@
+/*
+ *  Copyright 2017 Carlos David Brito Pacheco
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ * 
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ * 
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef CARLOSB_LEASE_CHANNEL_HPP
+#define CARLOSB_LEASE_CHANNEL_HPP
+
+#include "mpmc_ring.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace carlosb
+{
+    /**
+     * @brief      Bounded lock-free channel moving acquired objects between
+     * threads.
+     *
+     * Sending moves a lease into a `mpmc_ring` and receiving moves it out,
+     * so ownership changes hands without touching the reference count of
+     * the lender nor its mutex. The receiver releases the object to its
+     * pool as usual. Leases left in the channel when it is destroyed are
+     * released then.
+     *
+     * Any number of threads may send and receive. The blocking `send()` and
+     * `receive()` retry briefly and then sleep until the other side makes
+     * progress or the channel is closed; the mutex is only taken on that
+     * slow path.
+     *
+     * @tparam     Lease  Type of the leases, e.g.
+     * `object_pool<T>::acquired_type`.
+     */
+    template <class _Lease>
+    class lease_channel
+    {
+    public:
+        using lease_type        = _Lease;       ///< Type of the leases.
+        using size_type         = std::size_t;  ///< Size type used.
+
+        /**
+         * @brief      Constructs an open channel.
+         *
+         * @param[in]  capacity  Minimum number of leases the channel can
+         * hold. It is rounded up to a power of two.
+         */
+        explicit
+        lease_channel(size_type capacity)
+            :   m_ring(capacity),
+                m_closed(false),
+                m_sending(0),
+                m_waiting_senders(0),
+                m_waiting_receivers(0)
+        {}
+
+        lease_channel(const lease_channel&) = delete;
+        lease_channel& operator=(const lease_channel&) = delete;
+
+        /**
+         * @brief      Sends `lease` if the channel is open and has room.
+         *
+         * @param[in]  lease  The lease. It is left untouched if it was not
+         * sent.
+         *
+         * @return     Whether the lease was sent.
+         */
+        bool try_send(_Lease&& lease)
+        {
+            if (!this->begin_send())
+                return false;
+
+            bool sent = m_ring.try_push(std::move(lease));
+            this->end_send(sent);
+            return sent;
+        }
+
+        /**
+         * @brief      Sends `lease`, waiting for room if needed.
+         *
+         * @param[in]  lease  The lease. It is left untouched if it was not
+         * sent.
+         *
+         * @return     Whether the lease was sent, i.e. `false` if the channel
+         * was closed.
+         */
+        bool send(_Lease&& lease)
+        {
+            if (!this->begin_send())
+                return false;
+
+            for (size_type spins = 0; !m_ring.try_push(std::move(lease)); ++spins)
+            {
+                if (spins < spin_limit)
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_waiting_senders.fetch_add(1);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                m_not_full.wait(lock, [this, &lease] (void) { return m_ring.try_push(std::move(lease)); });
+                m_waiting_senders.fetch_sub(1);
+                break;
+            }
+
+            this->end_send(true);
+            return true;
+        }
+
+        /**
+         * @brief      Receives a lease if there is one.
+         *
+         * @param[out] lease  Assigned the received lease.
+         *
+         * @return     Whether a lease was received.
+         */
+        bool try_receive(_Lease& lease)
+        {
+            if (!m_ring.try_pop(lease))
+                return false;
+
+            this->wake_sender();
+            return true;
+        }
+
+        /**
+         * @brief      Receives a lease, waiting for one if needed.
+         *
+         * @return     The lease, which is empty if the channel was closed and
+         * drained.
+         */
+        _Lease receive()
+        {
+            _Lease lease;
+            for (size_type spins = 0; !m_ring.try_pop(lease); ++spins)
+            {
+                if (this->drained())
+                {
+                    // a lease pushed before the last sender finished
+                    if (m_ring.try_pop(lease))
+                        break;
+                    return _Lease();
+                }
+
+                if (spins < spin_limit)
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                bool received = false;
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_waiting_receivers.fetch_add(1);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                m_not_empty.wait(lock, [this, &lease, &received] (void)
+                {
+                    received = m_ring.try_pop(lease);
+                    return received || this->drained();
+                });
+                m_waiting_receivers.fetch_sub(1);
+
+                if (!received && !m_ring.try_pop(lease))
+                    return _Lease();
+                break;
+            }
+
+            this->wake_sender();
+            return lease;
+        }
+
+        /**
+         * @brief      Closes the channel. Later sends fail, and receivers
+         * stop waiting once the sends in progress have finished and the
+         * channel is drained.
+         */
+        void close()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_closed.store(true);
+            }
+            m_not_empty.notify_all();
+        }
+
+        /**
+         * @brief      Checks if the channel is closed.
+         */
+        bool closed() const
+        {
+            return m_closed.load(std::memory_order_acquire);
+        }
+
+        /**
+         * @brief      Returns the number of leases in the channel. The result
+         * may be stale if the channel is used concurrently.
+         */
+        size_type size_approx() const
+        {
+            return m_ring.size_approx();
+        }
+
+    private:
+        static constexpr size_type spin_limit = 64;     ///< Retries before a blocking call sleeps.
+
+        /**
+         * Registers a send in progress, unless the channel is closed. A
+         * receiver which sees the channel closed with no send in progress
+         * knows that no lease can arrive anymore.
+         */
+        inline bool begin_send()
+        {
+            m_sending.fetch_add(1);
+            if (m_closed.load())
+            {
+                this->end_send(false);
+                return false;
+            }
+            return true;
+        }
+
+        /**
+         * Ends a send and wakes the receivers which may be waiting for it.
+         */
+        inline void end_send(bool sent)
+        {
+            m_sending.fetch_sub(1);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (m_waiting_receivers.load(std::memory_order_relaxed) == 0)
+                return;
+
+            {
+                // the receiver is either waiting or about to check again
+                std::lock_guard<std::mutex> lock(m_mutex);
+            }
+            if (m_closed.load())
+                m_not_empty.notify_all();
+            else if (sent)
+                m_not_empty.notify_one();
+        }
+
+        /**
+         * Wakes a sender waiting for room after a lease was received.
+         */
+        inline void wake_sender()
+        {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (m_waiting_senders.load(std::memory_order_relaxed) == 0)
+                return;
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+            }
+            m_not_full.notify_one();
+        }
+
+        /**
+         * Checks if the channel is closed and no send is in progress.
+         */
+        inline bool drained() const
+        {
+            return m_closed.load() && m_sending.load() == 0;
+        }
+
+        mpmc_ring<_Lease>           m_ring;                 ///< Leases in transit.
+        std::atomic<bool>           m_closed;               ///< Whether senders are done.
+        std::atomic<size_type>      m_sending;              ///< Sends in progress.
+        std::atomic<size_type>      m_waiting_senders;      ///< Senders sleeping until there is room.
+        std::atomic<size_type>      m_waiting_receivers;    ///< Receivers sleeping until there is a lease.
+        std::mutex                  m_mutex;                ///< Guards the sleeps.
+        std::condition_variable     m_not_full;             ///< Signaled when a lease is received.
+        std::condition_variable     m_not_empty;            ///< Signaled when a lease is sent or the channel is closed.
+    };
+}
+
+#endif
@@ -0,0 +1,216 @@
+/*
+ *  Copyright 2017 Carlos David Brito Pacheco
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ * 
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ * 
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef CARLOSB_MPMC_RING_HPP
+#define CARLOSB_MPMC_RING_HPP
+
+#include "object_pool.hpp"
+
+#include <atomic>
+
+namespace carlosb
+{
+    /**
+     * @brief      Bounded lock-free queue for any number of producers and
+     * consumers.
+     *
+     * Every cell carries a sequence number telling whether it is ready to be
+     * written or read in the current lap of the ring (D. Vyukov's bounded
+     * MPMC queue). Pushing and popping each take a single successful CAS,
+     * on positions padded onto separate cache lines, and cells are never reused
+     * before they are read, so there is no ABA problem.
+     *
+     * @tparam     T     Type of the elements. Must be default constructible
+     * and move assignable.
+     */
+    template <class _Tp>
+    class mpmc_ring
+    {
+    public:
+        using value_type        = _Tp;          ///< Type of the elements.
+        using size_type         = std::size_t;  ///< Size type used.
+
+        /**
+         * @brief      Constructs an empty ring.
+         *
+         * @param[in]  capacity  Minimum number of elements the ring can
+         * hold. It is rounded up to a power of two.
+         */
+        explicit
+        mpmc_ring(size_type capacity)
+            :   m_mask(round_up(capacity) - 1),
+                m_cells(new cell[m_mask + 1])
+        {
+            for (size_type i = 0; i <= m_mask; ++i)
+                m_cells[i].sequence.store(i, std::memory_order_relaxed);
+            m_enqueue_pos.store(0, std::memory_order_relaxed);
+            m_dequeue_pos.store(0, std::memory_order_relaxed);
+        }
+
+        mpmc_ring(const mpmc_ring&) = delete;
+        mpmc_ring& operator=(const mpmc_ring&) = delete;
+
+        /**
+         * @brief      Pushes `value` at the back of the ring.
+         *
+         * @param[in]  value  The value. It is left untouched if the ring is
+         * full.
+         *
+         * @return     Whether the value was pushed, i.e. the ring was not
+         * full. A push may also fail while the pop of the cell it wraps
+         * around to is still in progress.
+         */
+        bool try_push(_Tp&& value)
+        {
+            cell* c;
+            size_type pos = m_enqueue_pos.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                c = &m_cells[pos & m_mask];
+                size_type seq = c->sequence.load(std::memory_order_acquire);
+                std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+                if (diff == 0)
+                {
+                    if (m_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if (diff < 0)
+                {
+                    return false;   // the cell has not been read since the last lap
+                }
+                else
+                {
+                    pos = m_enqueue_pos.load(std::memory_order_relaxed);
+                }
+            }
+
+            c->data = std::move(value);
+            c->sequence.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * @brief      Pushes a copy of `value` at the back of the ring.
+         *
+         * @param[in]  value  The value.
+         *
+         * @return     Whether the value was pushed, i.e. the ring was not
+         * full.
+         */
+        bool try_push(const _Tp& value)
+        {
+            _Tp copy(value);
+            return this->try_push(std::move(copy));
+        }
+
+        /**
+         * @brief      Pops the element at the front of the ring.
+         *
+         * @param[out] value  Assigned the element, if any.
+         *
+         * @return     Whether an element was popped, i.e. the ring was not
+         * empty.
+         */
+        bool try_pop(_Tp& value)
+        {
+            cell* c;
+            size_type pos = m_dequeue_pos.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                c = &m_cells[pos & m_mask];
+                size_type seq = c->sequence.load(std::memory_order_acquire);
+                std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+                if (diff == 0)
+                {
+                    if (m_dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if (diff < 0)
+                {
+                    return false;   // the cell has not been written in this lap
+                }
+                else
+                {
+                    pos = m_dequeue_pos.load(std::memory_order_relaxed);
+                }
+            }
+
+            value = std::move(c->data);
+            c->sequence.store(pos + m_mask + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * @brief      Returns the number of elements the ring can hold.
+         */
+        size_type capacity() const
+        {
+            return m_mask + 1;
+        }
+
+        /**
+         * @brief      Returns the number of elements in the ring. The result
+         * may be stale if the ring is used concurrently.
+         */
+        size_type size_approx() const
+        {
+            size_type tail = m_enqueue_pos.load(std::memory_order_relaxed);
+            size_type head = m_dequeue_pos.load(std::memory_order_relaxed);
+            return tail > head ? tail - head : 0;
+        }
+
+    private:
+        struct cell
+        {
+            std::atomic<size_type>  sequence;
+            _Tp                     data;
+        };
+
+        static size_type round_up(size_type capacity)
+        {
+            size_type n = 1;
+            while (n < capacity)
+                n <<= 1;
+            return n;
+        }
+
+        // The positions are kept apart by padding rather than `alignas`,
+        // since rings live inside heap objects and `new` does not honour
+        // extended alignments before C++17.
+        size_type                           m_mask;         ///< Capacity minus one.
+        std::unique_ptr<cell[]>             m_cells;        ///< Cells of the ring.
+        char                                m_padding0[cache_line_size];
+        std::atomic<size_type>              m_enqueue_pos;  ///< Position of the next push.
+        char                                m_padding1[cache_line_size];
+        std::atomic<size_type>              m_dequeue_pos;  ///< Position of the next pop.
+        char                                m_padding2[cache_line_size];
+    };
+}
+
+#endif
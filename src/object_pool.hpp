@@ -35,12 +35,59 @@
 #include <stack>
 #include <stdexcept>
 #include <type_traits>
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <chrono>
 #include <cstring>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <new>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 #include <iostream>
 
+#if !defined(CARLOSB_NO_PROBES) && defined(__has_include)
+#   if __has_include(<sys/sdt.h>)
+#       include <sys/sdt.h>
+#       define CARLOSB_HAS_SDT 1
+#   endif
+#endif
+
+/**
+ * USDT probes of the `object_pool` provider, e.g. for
+ * `bpftrace -e 'usdt:./app:object_pool:acquire_miss { @[ustack] = count(); }'`.
+ * The first argument of every probe is the address of the pool.
+ *
+ * | Probe        | Arguments                                  |
+ * |--------------|--------------------------------------------|
+ * | acquire_hit  | pool, free objects left                    |
+ * | acquire_miss | pool                                       |
+ * | wait_begin   | pool                                       |
+ * | wait_end     | pool, 1 if an object was acquired, ns      |
+ * | release      | pool, object                               |
+ * | grow         | pool, old capacity, new capacity           |
+ * | resize       | pool, old free objects, new free objects   |
+ *
+ * A probe which is not traced costs a single `nop`. Without
+ * `<sys/sdt.h>`, or with `CARLOSB_NO_PROBES` defined, the probes compile
+ * to nothing.
+ */
+#ifdef CARLOSB_HAS_SDT
+#   define CARLOSB_PROBE1(name, a)          DTRACE_PROBE1(object_pool, name, a)
+#   define CARLOSB_PROBE2(name, a, b)       DTRACE_PROBE2(object_pool, name, a, b)
+#   define CARLOSB_PROBE3(name, a, b, c)    DTRACE_PROBE3(object_pool, name, a, b, c)
+#else
+#   define CARLOSB_PROBE1(name, a)          ((void) 0)
+#   define CARLOSB_PROBE2(name, a, b)       ((void) 0)
+#   define CARLOSB_PROBE3(name, a, b, c)    ((void) 0)
+#endif
+
 namespace carlosb
 {
     /**
@@ -67,16 +114,367 @@ namespace carlosb
 
         struct none_helper
         {};
+
+        /**
+         * Rounds `value` up to the next multiple of `alignment`, which must
+         * be a power of two.
+         */
+        constexpr std::size_t align_up(std::size_t value, std::size_t alignment)
+        {
+            return (value + alignment - 1) & ~(alignment - 1);
+        }
     }
 
+    /**
+     * Size of a cache line, i.e. the minimum offset between two objects
+     * needed to avoid false sharing.
+     */
+#ifdef __cpp_lib_hardware_interference_size
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Winterference-size"
+#endif
+    constexpr std::size_t cache_line_size = std::hardware_destructive_interference_size;
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#else
+    constexpr std::size_t cache_line_size = 64;
+#endif
+
     typedef int detail::none_helper::*none_t;
     none_t const none = (static_cast<none_t>(0)) ;
 
+    /**
+     * Identifies a tenant sharing a pool. The constructor is explicit so that
+     * a time limit or a count is never taken for a tenant by mistake.
+     */
+    struct tenant_t
+    {
+        constexpr explicit tenant_t(std::size_t id) : value(id) { }
+
+        constexpr bool operator==(const tenant_t& other) const { return value == other.value; }
+        constexpr bool operator!=(const tenant_t& other) const { return value != other.value; }
+
+        /**
+         * Hashes tenants for unordered containers.
+         */
+        struct hash
+        {
+            std::size_t operator()(const tenant_t& tenant) const { return std::hash<std::size_t>()(tenant.value); }
+        };
+
+        std::size_t value;
+    };
+    constexpr tenant_t no_tenant{static_cast<std::size_t>(-1)};    ///< Tenant of objects acquired without a tenant.
+
+    typedef std::size_t affinity_t;
+    affinity_t const no_affinity = (static_cast<affinity_t>(-1)) ;  ///< Key of objects acquired without affinity.
+
+    /**
+     * Determines when the objects of a pool are reset to the prototype the
+     * pool was constructed with.
+     */
+    enum class reset_policy
+    {
+        never,          ///< Objects keep their state between uses.
+        on_release,     ///< Objects are reset when they return to the pool.
+        on_acquire      ///< Objects are reset when they are acquired.
+    };
+
+    namespace detail
+    {
+        /**
+         * Returns the lease site of the calling thread, or `nullptr`.
+         */
+        inline const char*& current_lease_site()
+        {
+            static thread_local const char* site = nullptr;
+            return site;
+        }
+    }
+
+    /**
+     * @brief      Tags the objects acquired by the calling thread, while in
+     * scope, with a call site.
+     *
+     * The tag is only recorded by pools with site tracking enabled, see
+     * `object_pool::set_site_tracking()`. Scopes nest; the innermost wins.
+     * `CARLOSB_LEASE_SITE()` opens a scope tagged with the current file and
+     * line.
+     */
+    class lease_site
+    {
+    public:
+        /**
+         * @param[in]  site  Name of the call site. Must outlive the leases
+         * acquired in the scope, e.g. a string literal.
+         */
+        explicit
+        lease_site(const char* site)
+            :   m_previous(detail::current_lease_site())
+        {
+            detail::current_lease_site() = site;
+        }
+
+        lease_site(const lease_site&) = delete;
+        lease_site& operator=(const lease_site&) = delete;
+
+        ~lease_site()
+        {
+            detail::current_lease_site() = m_previous;
+        }
+
+    private:
+        const char*     m_previous;     ///< Site of the enclosing scope.
+    };
+
+#define CARLOSB_STRINGIZE_(x)   #x
+#define CARLOSB_STRINGIZE(x)    CARLOSB_STRINGIZE_(x)
+
+    /**
+     * Tags the leases acquired until the end of the enclosing block with
+     * `"<file>:<line>"`.
+     */
+#define CARLOSB_LEASE_SITE() \
+    ::carlosb::lease_site carlosb_lease_site_(__FILE__ ":" CARLOSB_STRINGIZE(__LINE__))
+
+    /**
+     * Objects lent from one call site and not yet returned.
+     */
+    struct site_usage
+    {
+        std::string                         site;           ///< Call site, or `"<unknown>"` for untagged leases.
+        std::size_t                         outstanding;    ///< Number of objects lent from the site.
+        std::chrono::steady_clock::duration oldest;         ///< Age of the oldest of them.
+    };
+
+    /**
+     * Use of one slot of a pool.
+     */
+    struct slot_wear
+    {
+        const void*                             slot;           ///< Address of the slot.
+        std::uint64_t                           acquisitions;   ///< Number of times the object in the slot was lent.
+        std::chrono::steady_clock::duration     held;           ///< Total time it was lent, up to its last return.
+        std::chrono::steady_clock::time_point   last_acquired;  ///< When it was last lent.
+    };
+
+    /**
+     * How evenly the slots of a pool are used.
+     *
+     * `reuse[0]` counts the slots never lent, `reuse[1]` the slots lent
+     * once and `reuse[i]` for `i > 1` the slots lent between `2^(i-1)` and
+     * `2^i - 1` times.
+     */
+    struct wear_report
+    {
+        std::size_t                 slots;          ///< Number of slots, i.e. the capacity of the pool.
+        std::size_t                 never_used;     ///< Number of slots never lent.
+        std::vector<std::size_t>    reuse;          ///< Number of slots by times lent, in powers of two.
+        std::vector<slot_wear>      hottest;        ///< Most lent slots, most lent first.
+        std::vector<slot_wear>      coldest;        ///< Least lent slots which were lent, least lent first.
+    };
+
+    /**
+     * Counts of a pool taken at a given moment.
+     */
+    struct pool_snapshot
+    {
+        std::size_t     free;       ///< Number of free objects.
+        std::size_t     in_use;     ///< Number of acquired objects.
+        std::size_t     capacity;   ///< Number of objects the pool can hold.
+    };
+
+    /**
+     * Counters of a pool, read without taking its lock.
+     *
+     * Counters only grow over the lifetime of the pool. The wait histogram
+     * holds, for each bucket, the number of waits in `acquire_wait()` which
+     * lasted up to `wait_bucket_bound(i)` seconds but not less than the
+     * bound of the previous bucket; longer waits are only counted by
+     * `waits`.
+     */
+    struct pool_metrics
+    {
+        static constexpr std::size_t wait_bucket_count = 6;    ///< Number of bounded wait buckets.
+
+        /**
+         * Returns the upper bound of wait bucket `i`, in seconds.
+         */
+        static double wait_bucket_bound(std::size_t i)
+        {
+            static const double bounds[wait_bucket_count] = { 0.0001, 0.001, 0.01, 0.1, 1.0, 10.0 };
+            return bounds[i];
+        }
+
+        std::uint64_t   acquisitions;                       ///< Number of acquisition attempts.
+        std::uint64_t   misses;                             ///< Number of attempts which found no free object.
+        std::uint64_t   releases;                           ///< Number of objects returned to the pool.
+        std::uint64_t   waits;                              ///< Number of waits in `acquire_wait()`.
+        std::uint64_t   wait_buckets[wait_bucket_count];    ///< Waits by duration.
+        double          wait_seconds;                       ///< Total time spent waiting.
+        std::size_t     free;                               ///< Number of free objects.
+        std::size_t     in_use;                             ///< Number of acquired objects.
+        std::size_t     capacity;                           ///< Number of objects the pool can hold.
+    };
+
+    /**
+     * Counters of a pool laid out so that they can live in memory shared
+     * with other processes, e.g. a `shm_stats_page`.
+     *
+     * The pool writes them under a sequence lock: `sequence` is odd while a
+     * write is in progress. Readers copy the counters and retry if the
+     * sequence moved meanwhile, so they never block the pool.
+     */
+    struct stats_slot
+    {
+        std::atomic<std::uint64_t>  sequence;                                   ///< Odd while being written.
+        std::atomic<std::uint64_t>  acquisitions;                               ///< See `pool_metrics`.
+        std::atomic<std::uint64_t>  misses;                                     ///< See `pool_metrics`.
+        std::atomic<std::uint64_t>  releases;                                   ///< See `pool_metrics`.
+        std::atomic<std::uint64_t>  waits;                                      ///< See `pool_metrics`.
+        std::atomic<std::uint64_t>  wait_buckets[pool_metrics::wait_bucket_count]; ///< See `pool_metrics`.
+        std::atomic<std::uint64_t>  wait_nanoseconds;                           ///< Total time spent waiting.
+        std::atomic<std::uint64_t>  free;                                       ///< See `pool_metrics`.
+        std::atomic<std::uint64_t>  in_use;                                     ///< See `pool_metrics`.
+        std::atomic<std::uint64_t>  capacity;                                   ///< See `pool_metrics`.
+
+        stats_slot()
+        {
+            this->clear();
+        }
+
+        /**
+         * @brief      Zeroes the counters. Must not race with `store()`.
+         */
+        void clear()
+        {
+            sequence.store(0, std::memory_order_relaxed);
+            this->write(pool_metrics());
+        }
+
+        /**
+         * @brief      Writes `m` into the slot. Writers must not race with
+         * each other.
+         */
+        void store(const pool_metrics& m)
+        {
+            std::uint64_t seq = sequence.load(std::memory_order_relaxed);
+            sequence.store(seq + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            this->write(m);
+            sequence.store(seq + 2, std::memory_order_release);
+        }
+
+        /**
+         * @brief      Reads a consistent copy of the counters.
+         *
+         * @param[out] m     The counters.
+         *
+         * @return     `false` if a write was in progress, in which case `m`
+         * is unspecified and the read should be retried.
+         */
+        bool try_load(pool_metrics& m) const
+        {
+            std::uint64_t seq = sequence.load(std::memory_order_acquire);
+            if (seq & 1)
+                return false;
+
+            m.acquisitions  = acquisitions.load(std::memory_order_relaxed);
+            m.misses        = misses.load(std::memory_order_relaxed);
+            m.releases      = releases.load(std::memory_order_relaxed);
+            m.waits         = waits.load(std::memory_order_relaxed);
+            for (std::size_t i = 0; i < pool_metrics::wait_bucket_count; ++i)
+                m.wait_buckets[i] = wait_buckets[i].load(std::memory_order_relaxed);
+            m.wait_seconds  = wait_nanoseconds.load(std::memory_order_relaxed) * 1e-9;
+            m.free          = static_cast<std::size_t>(free.load(std::memory_order_relaxed));
+            m.in_use        = static_cast<std::size_t>(in_use.load(std::memory_order_relaxed));
+            m.capacity      = static_cast<std::size_t>(capacity.load(std::memory_order_relaxed));
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return sequence.load(std::memory_order_relaxed) == seq;
+        }
+
+    private:
+        void write(const pool_metrics& m)
+        {
+            acquisitions.store(m.acquisitions, std::memory_order_relaxed);
+            misses.store(m.misses, std::memory_order_relaxed);
+            releases.store(m.releases, std::memory_order_relaxed);
+            waits.store(m.waits, std::memory_order_relaxed);
+            for (std::size_t i = 0; i < pool_metrics::wait_bucket_count; ++i)
+                wait_buckets[i].store(m.wait_buckets[i], std::memory_order_relaxed);
+            wait_nanoseconds.store(static_cast<std::uint64_t>(m.wait_seconds * 1e9 + 0.5), std::memory_order_relaxed);
+            free.store(m.free, std::memory_order_relaxed);
+            in_use.store(m.in_use, std::memory_order_relaxed);
+            capacity.store(m.capacity, std::memory_order_relaxed);
+        }
+    };
+
+    /**
+     * Parameters of the demand forecast used to grow a pool ahead of bursts.
+     *
+     * Acquisitions are counted over windows of `interval`. An acquisition
+     * which finds the pool empty is a miss. At the end of each window the
+     * exponentially weighted moving averages of acquisitions and misses are
+     * updated, and the pool is grown so that it holds at least
+     * `headroom * miss average * ramp` free objects, where `ramp` is the
+     * ratio between the acquisitions of the last window and their average
+     * (never less than one).
+     */
+    struct forecast_policy
+    {
+        std::chrono::milliseconds   interval;   ///< Length of a sampling window.
+        double                      smoothing;  ///< Weight of the last window in the averages, in (0, 1].
+        double                      headroom;   ///< Multiplier applied to the forecast.
+        std::size_t                 max_size;   ///< Number of objects the pool will not grow beyond.
+    };
+
+    namespace detail
+    {
+        /**
+         * Copies `prototype` into `obj`. Trivially copyable types are
+         * copied with a single `memcpy`, other types are copy-assigned.
+         */
+        template <class _Tp>
+        inline void reset_to(_Tp& obj, const _Tp& prototype, std::true_type)
+        {
+            std::memcpy(static_cast<void*>(&obj), static_cast<const void*>(&prototype), sizeof(_Tp));
+        }
+
+        template <class _Tp>
+        inline void reset_to_assign(_Tp& obj, const _Tp& prototype, std::true_type)
+        {
+            obj = prototype;
+        }
+
+        // Pools of types which are not CopyAssignable cannot have a
+        // prototype, so there is nothing to reset.
+        template <class _Tp>
+        inline void reset_to_assign(_Tp&, const _Tp&, std::false_type)
+        {}
+
+        template <class _Tp>
+        inline void reset_to(_Tp& obj, const _Tp& prototype, std::false_type)
+        {
+            reset_to_assign(obj, prototype, std::is_copy_assignable<_Tp>());
+        }
+
+        template <class _Tp>
+        inline void reset_to(_Tp& obj, const _Tp& prototype)
+        {
+            reset_to(obj, prototype, std::integral_constant<bool, std::is_trivially_copyable<_Tp>::value>());
+        }
+    }
+
     /**
      * Contains meta-functions to determine if an object of type `T` satisfies
      * the requirements of some concept. Currently implemented:
      * - `is_lockable<_Tp>`
      * - `is_allocator<_Tp>`
+     * - `has_slot_alignment<_Tp>`
+     * - `has_slab_colors<_Tp>`
      */
     namespace type_traits
     {
@@ -109,8 +507,158 @@ namespace carlosb
             decltype(std::declval<_Tp>().deallocate(std::declval<typename _Tp::value_type*>(), std::declval<typename _Tp::size_type>()))
         >> : std::true_type
         {};
+
+        template <class _Tp, class = void>
+        struct has_slot_alignment : public std::false_type
+        {};
+
+        template <class _Tp>
+        struct has_slot_alignment<_Tp, detail::void_t<
+            decltype(_Tp::slot_alignment)
+        >> : std::true_type
+        {};
+
+        template <class _Tp, class = void>
+        struct has_slab_colors : public std::false_type
+        {};
+
+        template <class _Tp>
+        struct has_slab_colors<_Tp, detail::void_t<
+            decltype(_Tp::slab_colors)
+        >> : std::true_type
+        {};
+    }
+
+    namespace detail
+    {
+        template <class _Allocator, bool = type_traits::has_slot_alignment<_Allocator>::value>
+        struct allocator_alignment
+        {
+            static constexpr std::size_t value = _Allocator::slot_alignment;
+        };
+
+        template <class _Allocator>
+        struct allocator_alignment<_Allocator, false>
+        {
+            static constexpr std::size_t value = 1;
+        };
+
+        template <class _Allocator, bool = type_traits::has_slab_colors<_Allocator>::value>
+        struct allocator_colors
+        {
+            static constexpr std::size_t value = _Allocator::slab_colors > 0 ? _Allocator::slab_colors : 1;
+        };
+
+        template <class _Allocator>
+        struct allocator_colors<_Allocator, false>
+        {
+            static constexpr std::size_t value = 1;
+        };
+
+        /**
+         * Describes how the slots of a pool are laid out in a slab.
+         *
+         * Every slot is aligned to `alignment` and the distance between two
+         * consecutive slots is `stride`. Allocators may request a wider
+         * alignment than `alignof(T)` by exposing a `slot_alignment`
+         * constant, in which case they must also return storage aligned to
+         * it. Otherwise the pool only relies on the alignment that
+         * `operator new` guarantees and aligns the slots itself.
+         *
+         * Allocators may also expose a `slab_colors` constant. The first slot
+         * of the n-th slab is then shifted by `(n % colors) * color_step`
+         * bytes, so that slots at the same offset in different slabs do not
+         * map to the same cache sets.
+         */
+        template <class _Tp, class _Allocator>
+        struct slot_layout
+        {
+            static constexpr std::size_t alignment  = allocator_alignment<_Allocator>::value > alignof(_Tp)
+                                                    ? allocator_alignment<_Allocator>::value
+                                                    : alignof(_Tp);
+            static constexpr std::size_t stride     = align_up(sizeof(_Tp), alignment);
+            static constexpr std::size_t guaranteed = type_traits::has_slot_alignment<_Allocator>::value
+                                                    ? alignment
+                                                    : (alignof(_Tp) < alignof(std::max_align_t) ? alignof(_Tp) : alignof(std::max_align_t));
+            static constexpr std::size_t colors     = allocator_colors<_Allocator>::value;
+            static constexpr std::size_t color_step = align_up(cache_line_size, alignment);
+        };
     }
 
+    /**
+     * @brief      Allocator which aligns every slot of an `object_pool` to
+     * `Align` bytes and pads it to a multiple of `Align` bytes.
+     *
+     * Using it as the allocator of an `object_pool` guarantees that no two
+     * objects of the pool share a cache line, thus avoiding false sharing
+     * between objects owned by different threads. It also supports
+     * over-aligned types.
+     *
+     * @tparam     T       Type of the objects.
+     * @tparam     Align   Alignment of each slot. Must be a power of two.
+     * @tparam     Colors  Number of slab colors. With more than one color
+     * the slabs carved by the pool start at staggered cache lines.
+     */
+    template <class _Tp, std::size_t _Align = cache_line_size, std::size_t _Colors = 1>
+    class cache_aligned_allocator
+    {
+        static_assert((_Align & (_Align - 1)) == 0, "Align must be a power of two.");
+    public:
+        using value_type        = _Tp;
+        using size_type         = std::size_t;
+        using difference_type   = std::ptrdiff_t;
+
+        static constexpr std::size_t slot_alignment = _Align > alignof(_Tp) ? _Align : alignof(_Tp);
+        static constexpr std::size_t slab_colors    = _Colors;
+
+        template <class _Up>
+        struct rebind
+        {
+            using other = cache_aligned_allocator<_Up, _Align, _Colors>;
+        };
+
+        cache_aligned_allocator() noexcept
+        {}
+
+        template <class _Up>
+        cache_aligned_allocator(const cache_aligned_allocator<_Up, _Align, _Colors>&) noexcept
+        {}
+
+        _Tp* allocate(size_type n)
+        {
+            // The pointer returned by operator new is stored right before the
+            // aligned block so that it can be recovered in deallocate().
+            char* raw = static_cast<char*>(::operator new(n * sizeof(_Tp) + slot_alignment + sizeof(void*)));
+            std::uintptr_t aligned = detail::align_up(reinterpret_cast<std::uintptr_t>(raw) + sizeof(void*), slot_alignment);
+            reinterpret_cast<void**>(aligned)[-1] = raw;
+            return reinterpret_cast<_Tp*>(aligned);
+        }
+
+        void deallocate(_Tp* ptr, size_type)
+        {
+            if (ptr)
+                ::operator delete(reinterpret_cast<void**>(ptr)[-1]);
+        }
+
+        template <class _Up>
+        bool operator==(const cache_aligned_allocator<_Up, _Align, _Colors>&) const noexcept
+        {
+            return true;
+        }
+
+        template <class _Up>
+        bool operator!=(const cache_aligned_allocator<_Up, _Align, _Colors>&) const noexcept
+        {
+            return false;
+        }
+    };
+
+    template <class _Tp, std::size_t _Align, std::size_t _Colors>
+    constexpr std::size_t cache_aligned_allocator<_Tp, _Align, _Colors>::slot_alignment;
+
+    template <class _Tp, std::size_t _Align, std::size_t _Colors>
+    constexpr std::size_t cache_aligned_allocator<_Tp, _Align, _Colors>::slab_colors;
+
     template <
         class _Tp,
         class _Allocator,
@@ -142,6 +690,14 @@ namespace carlosb
         using allocator_type    = _Allocator;                ///< Type of allocator.
         using mutex_type        = _Mutex;                    ///< Type of mutex.
         using scoped_lock_type  = std::lock_guard<_Mutex>;   ///< Type of lock guard.
+
+        using task_type         = std::function<void()>;            ///< Type of the tasks handed to executors.
+        using executor_type     = std::function<void(task_type)>;   ///< Type of executors.
+        using watermark_callback = std::function<void(const pool_snapshot&)>; ///< Type of watermark callbacks.
+        using tenant_type       = tenant_t;                 ///< Identifies the tenants sharing a pool.
+        using affinity_type     = affinity_t;               ///< Key objects are preferably reused under.
+        using index_key_type    = std::size_t;              ///< Type of the keys free objects are indexed by.
+        using key_extractor     = std::function<index_key_type(const _Tp&)>; ///< Computes the index key of an object.
         
         /**
          * @brief      Constructs an empty pool.
@@ -171,6 +727,25 @@ namespace carlosb
             : m_pool(std::make_shared<impl>(count, value, alloc))
         {}
 
+        /**
+         * @brief      Constructs a pool with `count` copies of `value` which
+         * are reset to `value` according to `policy`.
+         *
+         * @param[in]  count   Number of elements.
+         * @param[in]  value   Prototype of the elements.
+         * @param[in]  policy  When objects are reset to the prototype.
+         * @param[in]  alloc   Allocator to be used.
+         *
+         * Trivially copyable types are reset with a single `memcpy`, other
+         * types are copy-assigned from the prototype. If a reset on acquire
+         * throws, the object goes back to the pool and the exception
+         * propagates. If a reset on release throws, the object is destroyed
+         * and the exception is swallowed.
+         */
+        object_pool(size_type count, const _Tp& value, reset_policy policy, const _Allocator& alloc = _Allocator())
+            : m_pool(std::make_shared<impl>(count, value, policy, alloc))
+        {}
+
         /**
          * @brief      Constructs the container with count default-inserted instances of T. No copies are made.
          *
@@ -240,64 +815,248 @@ namespace carlosb
          */
         acquired_type acquire()
         {
-            return m_pool->acquire();
+            return m_pool->acquire(no_tenant);
         }
 
         /**
-         * @brief      Waits until an object from the pool has been acquired or the `time_limit`
-         * has ran out.
+         * @brief      Acquires an object from the pool on behalf of `tenant`.
+         *
+         * @param[in]  tenant  Tenant the object is lent to.
+         *
+         * @return     Acquired object, which is empty if the pool has no free
+         * object or the tenant has reached its quota.
          *
-         * @return     Acquired object.
-         * 
          * Complexity
          * ----------
-         * Constant.
-         * 
-         * This method will lock until an object is available.
-         * One may achieve this manually by either:
-         * - pushing a new object to the pool
-         * - emplacing a new object into the pool
-         * - freeing other objects
+         * Constant on average.
          */
-        acquired_type acquire_wait(std::chrono::milliseconds time_limit = std::chrono::milliseconds::zero())
+        acquired_type acquire(tenant_type tenant)
         {
-            return m_pool->acquire_wait(time_limit);
+            return m_pool->acquire(tenant);
         }
 
         /**
-         * @brief      Attempts to acquire an object. If no object is acquired
-         * then it will construct an object from the parameters passed and
-         * return it. This method will always return an object that is initialized.
+         * @brief      Acquires `count` objects at once, or none of them.
          *
-         * @param[in]  args  Parameter pack
+         * @param[in]  count  Number of objects.
          *
-         * @tparam     Args       Types of the parameter
+         * @return     The acquired objects, which are none if the pool has
+         * fewer than `count` free objects.
          *
-         * @return     Acquired object.
+         * The objects are taken under a single lock, so concurrent callers
+         * cannot each end up holding part of the objects the other needs.
+         *
+         * Complexity
+         * ----------
+         * Linear in `count`.
          */
-        template <class... Args>
-        acquired_type allocate(Args&&... args)
+        std::vector<acquired_type> acquire_many(size_type count)
         {
-            return m_pool->allocate(std::forward<Args>(args)...);
+            return m_pool->acquire_many(count);
         }
 
         /**
-         * @brief      Pushes an object to the pool by copying it.
+         * @brief      Acquires the object last released under `key`, or any
+         * free object if it is not free.
+         *
+         * @param[in]  key   Key the object is reused under, e.g. a session.
+         *
+         * @return     Acquired object, which is empty if the pool has no free
+         * object.
+         *
+         * Objects acquired this way are parked under `key` when released, so
+         * that state they have warmed up survives until the next acquisition
+         * under the same key. Parked objects are only lent to other keys or
+         * to plain acquisitions once no other object is free. Only the last
+         * object released under a key is parked.
          *
-         * @param[in]  value  Object to be copied into the pool.
-         * 
          * Complexity
          * ----------
-         * Amortized constant.
+         * Constant on average.
          */
-        void push(const_reference value)
+        acquired_type acquire_affine(affinity_type key)
         {
-            m_pool->push(value);
+            return m_pool->acquire_affine(key);
         }
 
         /**
-         * @brief      Pushes an object to the pool by moving it.
-         * 
+         * @brief      Same as `acquire_affine()`, waiting until an object has
+         * been acquired or the `time_limit` has ran out.
+         *
+         * @param[in]  key         Key the object is reused under.
+         * @param[in]  time_limit  Maximum waiting time, zero meaning no limit.
+         *
+         * @return     Acquired object, which is empty if the time limit ran
+         * out.
+         */
+        acquired_type acquire_affine_wait(affinity_type key, std::chrono::milliseconds time_limit = std::chrono::milliseconds::zero())
+        {
+            return m_pool->acquire_wait(no_tenant, key, time_limit);
+        }
+
+        /**
+         * @brief      Acquires a free object satisfying `pred`.
+         *
+         * @param[in]  pred  Unary predicate taking a `const _Tp&`.
+         *
+         * @return     Acquired object, which is empty if no free object
+         * satisfies `pred`.
+         *
+         * Free objects are inspected in place, most recently released first,
+         * and `pred` is called with the pool locked: it must not use the
+         * pool.
+         *
+         * Complexity
+         * ----------
+         * Linear in the number of free objects.
+         */
+        template <class _Predicate>
+        acquired_type acquire_if(_Predicate pred)
+        {
+            return m_pool->acquire_if(pred);
+        }
+
+        /**
+         * @brief      Indexes the free objects by `key_of`.
+         *
+         * @param[in]  key_of  Computes the key of an object, or is empty to
+         * remove the index.
+         *
+         * Objects are indexed when they return to the pool, so `key_of` may
+         * depend on state changed while they were lent. It is called with
+         * the pool locked: it must not use the pool.
+         */
+        void set_index(key_extractor key_of)
+        {
+            m_pool->set_index(std::move(key_of));
+        }
+
+        /**
+         * @brief      Acquires a free object whose index key is `key`.
+         *
+         * @param[in]  key   Key computed by the extractor given to
+         * `set_index()`.
+         *
+         * @return     Acquired object, which is empty if no free object has
+         * the key or the pool is not indexed.
+         *
+         * Complexity
+         * ----------
+         * Constant on average.
+         */
+        acquired_type acquire_where(index_key_type key)
+        {
+            return m_pool->acquire_where(key);
+        }
+
+        /**
+         * @brief      Waits until an object from the pool has been acquired or the `time_limit`
+         * has ran out.
+         *
+         * @return     Acquired object.
+         * 
+         * Complexity
+         * ----------
+         * Constant.
+         * 
+         * This method will lock until an object is available.
+         * One may achieve this manually by either:
+         * - pushing a new object to the pool
+         * - emplacing a new object into the pool
+         * - freeing other objects
+         */
+        acquired_type acquire_wait(std::chrono::milliseconds time_limit = std::chrono::milliseconds::zero())
+        {
+            return m_pool->acquire_wait(no_tenant, no_affinity, time_limit);
+        }
+
+        /**
+         * @brief      Waits until an object from the pool has been acquired
+         * on behalf of `tenant` or the `time_limit` has ran out.
+         *
+         * @param[in]  tenant      Tenant the object is lent to.
+         * @param[in]  time_limit  Maximum waiting time, zero meaning no limit.
+         *
+         * @return     Acquired object.
+         *
+         * The call waits while the tenant has reached its quota, even if the
+         * pool has free objects.
+         */
+        acquired_type acquire_wait(tenant_type tenant, std::chrono::milliseconds time_limit = std::chrono::milliseconds::zero())
+        {
+            return m_pool->acquire_wait(tenant, no_affinity, time_limit);
+        }
+
+        /**
+         * @brief      Attempts to acquire an object. If no object is acquired
+         * then it will construct an object from the parameters passed and
+         * return it. This method will always return an object that is initialized.
+         *
+         * The object is constructed without holding the pool mutex. When the
+         * number of constructions in flight has reached the limit set with
+         * `set_max_concurrent_creations()`, the call waits until either an
+         * object is released or a construction finishes.
+         *
+         * @param[in]  args  Parameter pack
+         *
+         * @tparam     Args       Types of the parameter
+         *
+         * @return     Acquired object.
+         */
+        template <class... Args>
+        acquired_type allocate(Args&&... args)
+        {
+            return m_pool->allocate(std::forward<Args>(args)...);
+        }
+
+        /**
+         * @brief      Waits up to `wait_budget` for a free object. If none
+         * becomes available, constructs a new object from the parameters
+         * passed unless the pool already holds `max_extra` extra objects.
+         *
+         * @param[in]  wait_budget  Maximum time spent waiting for a free object.
+         * @param[in]  max_extra    Maximum number of extra objects in the
+         * pool, including those constructed by other calls.
+         * @param[in]  args         Parameter pack
+         *
+         * @tparam     Args       Types of the parameter
+         *
+         * @return     Acquired object, which is empty if the budget ran out
+         * and either the pool already holds `max_extra` extra objects or
+         * the limit of `set_max_concurrent_creations()` is reached.
+         *
+         * `max_extra` bounds the extra objects of the whole pool, not of
+         * the call: callers passing different limits share one count, and a
+         * caller passing a lower limit than the count gets no extra object.
+         * Extra objects do not over-provision the pool permanently: while
+         * the pool holds extra objects and nobody is waiting, each released
+         * object is destroyed instead of returning to the pool, whichever
+         * call acquired it, until the pool is back to its size before
+         * hedging.
+         */
+        template <class... Args>
+        acquired_type acquire_hedged(std::chrono::milliseconds wait_budget, size_type max_extra, Args&&... args)
+        {
+            return m_pool->acquire_hedged(wait_budget, max_extra, std::forward<Args>(args)...);
+        }
+
+        /**
+         * @brief      Pushes an object to the pool by copying it.
+         *
+         * @param[in]  value  Object to be copied into the pool.
+         * 
+         * Complexity
+         * ----------
+         * Amortized constant.
+         */
+        void push(const_reference value)
+        {
+            m_pool->push(value);
+        }
+
+        /**
+         * @brief      Pushes an object to the pool by moving it.
+         * 
          * @param[in]  value  Object to be moved into the pool.
          * 
          * Complexity
@@ -378,6 +1137,242 @@ namespace carlosb
             m_pool->reserve(new_cap);
         }
 
+        /**
+         * @brief      Sets the executor used to destroy surplus objects.
+         *
+         * @param[in]  reclaimer  Executor which runs the destruction tasks,
+         * e.g. `background_reclaimer::executor()`. An empty executor
+         * destroys objects on the calling thread.
+         *
+         * Objects removed by `resize()` and the objects remaining when the
+         * last reference to the pool goes away are handed to the executor
+         * instead of being destroyed inline. The pool mutex is never held
+         * while objects are destroyed.
+         */
+        void set_reclaimer(executor_type reclaimer)
+        {
+            m_pool->set_reclaimer(std::move(reclaimer));
+        }
+
+        /**
+         * @brief      Sets callbacks invoked when the number of free objects
+         * crosses a watermark.
+         *
+         * @param[in]  low         `on_low` is invoked when size() falls below `low`.
+         * @param[in]  high        `on_high` is invoked when size() rises above `high`.
+         * @param[in]  hysteresis  Distance size() must move back past a
+         * watermark before its callback may be invoked again.
+         * @param[in]  on_low      Callback for the low watermark. May be empty.
+         * @param[in]  on_high     Callback for the high watermark. May be empty.
+         *
+         * Callbacks receive a snapshot of the pool taken when the watermark
+         * was crossed and are invoked by the thread which crossed it, after
+         * the pool mutex has been released. They may thus use the pool.
+         *
+         * @throws     std::invalid_argument if `low > high`.
+         */
+        void set_watermarks(size_type low, size_type high, size_type hysteresis,
+                            watermark_callback on_low, watermark_callback on_high)
+        {
+            m_pool->set_watermarks(low, high, hysteresis, std::move(on_low), std::move(on_high));
+        }
+
+        /**
+         * @brief      Limits the number of objects constructed concurrently
+         * by `allocate()` and `acquire_hedged()`.
+         *
+         * @param[in]  limit  Maximum number of constructions in flight, zero
+         * meaning no limit.
+         *
+         * Threads finding the pool empty while the limit is reached wait
+         * until an object is released or a construction finishes, which
+         * avoids a thundering herd of expensive constructions on a cold
+         * pool.
+         *
+         * This bounds concurrency, it does not deduplicate: an object
+         * belongs to the caller who constructed it and is never handed to
+         * a waiter. A waiter woken by a finished construction constructs its
+         * own object unless one was released meanwhile, so `n` cold callers
+         * still perform up to `n` constructions, at most `limit` at a time.
+         */
+        void set_max_concurrent_creations(size_type limit)
+        {
+            m_pool->set_max_concurrent_creations(limit);
+        }
+
+        /**
+         * @brief      Sets the quota of `tenant`.
+         *
+         * @param[in]  tenant           Tenant the quota applies to.
+         * @param[in]  max_outstanding  Maximum number of objects the tenant
+         * may hold at once.
+         * @param[in]  guaranteed       Number of objects kept available for
+         * the tenant: free objects are not lent to other tenants, nor to
+         * acquisitions without a tenant, while they are needed to honour
+         * the guarantee.
+         *
+         * Guarantees only reserve free objects; they do not grow the pool.
+         */
+        void set_tenant_quota(tenant_type tenant, size_type max_outstanding, size_type guaranteed = 0)
+        {
+            m_pool->set_tenant_quota(tenant, max_outstanding, guaranteed);
+        }
+
+        /**
+         * @brief      Returns the number of objects held by `tenant`.
+         *
+         * @param[in]  tenant  The tenant.
+         *
+         * @return     Number of objects acquired on behalf of `tenant` which
+         * have not returned to the pool. Only tenants with a quota are
+         * tracked; zero for the others.
+         */
+        size_type outstanding(tenant_type tenant) const
+        {
+            return m_pool->outstanding(tenant);
+        }
+
+        /**
+         * @brief      Removes the watermark callbacks.
+         */
+        void clear_watermarks()
+        {
+            m_pool->clear_watermarks();
+        }
+
+        /**
+         * @brief      Grows the pool ahead of demand.
+         *
+         * @param[in]  policy    Parameters of the forecast.
+         * @param[in]  executor  Executor on which the new objects are
+         * default-constructed, e.g. `background_reclaimer::executor()`.
+         *
+         * The forecast is updated by the acquiring threads when a window
+         * ends. Growth never happens on the acquiring thread, and at most
+         * one growth task is in flight at any time.
+         *
+         * @throws     std::invalid_argument if the policy or the executor is invalid.
+         */
+        void set_forecast(const forecast_policy& policy, executor_type executor)
+        {
+            m_pool->set_forecast(policy, std::move(executor));
+        }
+
+        /**
+         * @brief      Stops growing the pool ahead of demand.
+         */
+        void clear_forecast()
+        {
+            m_pool->clear_forecast();
+        }
+
+        /**
+         * @brief      Returns the counters of the pool.
+         *
+         * @return     The counters. They are read without taking the lock
+         * of the pool, so they may be slightly out of step with each other.
+         *
+         * Complexity
+         * ----------
+         * Constant.
+         */
+        pool_metrics metrics() const
+        {
+            return m_pool->metrics();
+        }
+
+        /**
+         * @brief      Mirrors the counters of the pool into `slot`.
+         *
+         * @param      slot  Slot the pool writes to on every acquisition and
+         * release, with relaxed atomic stores under the pool lock. Must stay
+         * valid until another slot is set. `nullptr` stops the mirroring.
+         *
+         * Used by `shm_stats_page` to publish the counters to other
+         * processes.
+         */
+        void set_stats_slot(stats_slot* slot)
+        {
+            m_pool->set_stats_slot(slot);
+        }
+
+        /**
+         * @brief      Enables or disables recording where lent objects were
+         * acquired.
+         *
+         * @param[in]  enabled  Whether to record lease sites.
+         *
+         * While enabled, every lease records the `lease_site` of the
+         * acquiring thread and the time it was acquired in a side table,
+         * which has its own lock. Meant for diagnostics: it costs a map
+         * insertion and removal per lease. Leases made while disabled are
+         * not reported. Disabling clears the table.
+         */
+        void set_site_tracking(bool enabled)
+        {
+            m_pool->set_site_tracking(enabled);
+        }
+
+        /**
+         * @brief      Returns the lent objects grouped by the site which
+         * acquired them, most outstanding first.
+         *
+         * Complexity
+         * ----------
+         * Linear in the number of lent objects.
+         */
+        std::vector<site_usage> outstanding_by_site() const
+        {
+            return m_pool->outstanding_by_site();
+        }
+
+        /**
+         * @brief      Enables or disables per-slot use counters.
+         *
+         * @param[in]  enabled  Whether to count the use of every slot.
+         *
+         * While enabled, every lease updates the number of times its slot
+         * was lent, the time it was held and when it was last lent, in a
+         * side table with its own lock. Counters survive the destruction of
+         * the object in a slot. Disabling clears them.
+         */
+        void set_wear_tracking(bool enabled)
+        {
+            m_pool->set_wear_tracking(enabled);
+        }
+
+        /**
+         * @brief      Reports how evenly the slots of the pool are used.
+         *
+         * @param[in]  count  Number of slots listed as hottest and coldest.
+         *
+         * Many slots never lent suggest a smaller `reserve()` or `resize()`;
+         * a few slots taking most of the leases show how much the LIFO
+         * reuse concentrates work.
+         *
+         * Complexity
+         * ----------
+         * Linearithmic in the number of slots ever lent.
+         */
+        wear_report wear(size_type count = 5) const
+        {
+            return m_pool->wear(count);
+        }
+
+        /**
+         * @brief      Writes `outstanding_by_site()`, one site per line.
+         *
+         * @param      os    Stream to write to.
+         */
+        void dump_outstanding_by_site(std::ostream& os) const
+        {
+            for (const site_usage& usage : m_pool->outstanding_by_site())
+            {
+                os << usage.site << ": " << usage.outstanding << " outstanding, oldest "
+                   << std::chrono::duration_cast<std::chrono::milliseconds>(usage.oldest).count() << " ms\n";
+            }
+        }
+
         /**
          * @brief      Returns the number of **free** elements in the pool.
          *
@@ -446,6 +1441,18 @@ namespace carlosb
             return m_pool->in_use();
         }
 
+        /**
+         * @brief      Exchanges the objects, storage and settings of the pool
+         * with those of `other`. Pools sharing ownership see the exchange.
+         *
+         * @param[in]  other  Other pool.
+         *
+         * Stats pages stay attached to the pool they were attached to.
+         *
+         * @throws     std::logic_error if either pool has objects in use,
+         * since lent objects return to the pool they came from and their
+         * storage must stay with it.
+         */
         void swap(object_pool& other)
         {
             m_pool->swap(*other.m_pool);
@@ -466,57 +1473,129 @@ namespace carlosb
         explicit
         impl(const _Allocator& alloc)
             :   m_managed_count(0),
-                m_capacity(4),
-                m_allocator(alloc)
+                m_hedged_count(0),
+                m_waiters(0),
+                m_creations(0),
+                m_max_creations(0),
+                m_reclaiming(0),
+                m_capacity(0),
+                m_allocator(alloc),
+                m_indexed_count(0),
+                m_parked_count(0),
+                m_parked_empty(0),
+                m_reset_policy(reset_policy::never),
+                m_reserved(0),
+                m_stats_slot(nullptr),
+                m_track_sites(false),
+                m_track_wear(false)
         {
-            for (size_type i = 0; i < m_capacity; ++i)
-                m_allocated_space.push(m_allocator.allocate(1));
+            this->reallocate(4);
         }
 
         impl(size_type count, const _Tp& value, const _Allocator& alloc = _Allocator())
-            :   m_managed_count(count),
-                m_capacity(count),
-                m_allocator(alloc)
+            :   m_managed_count(0),
+                m_hedged_count(0),
+                m_waiters(0),
+                m_creations(0),
+                m_max_creations(0),
+                m_reclaiming(0),
+                m_capacity(0),
+                m_allocator(alloc),
+                m_indexed_count(0),
+                m_parked_count(0),
+                m_parked_empty(0),
+                m_reset_policy(reset_policy::never),
+                m_reserved(0),
+                m_stats_slot(nullptr),
+                m_track_sites(false),
+                m_track_wear(false)
         {   
             static_assert(std::is_copy_constructible<_Tp>::value,
                           "T must be CopyConstructible to use this constructor.");
 
-            for (size_type i = 0; i < m_managed_count; ++i)
+            this->reallocate(count);
+            for (; m_managed_count < count; ++m_managed_count)
             {
-                _Tp* obj = m_allocator.allocate(1);
+                _Tp* obj = m_allocated_space.top();
                 ::new((void *) (obj)) _Tp(value);
-                m_free_objects.push(obj);
+                m_allocated_space.pop();
+                this->push_free(obj);
+            }
+            this->publish();
+        }
+
+        impl(size_type count, const _Tp& value, reset_policy policy, const _Allocator& alloc = _Allocator())
+            :   impl(count, value, alloc)
+        {
+            static_assert(std::is_copy_assignable<_Tp>::value,
+                          "T must be CopyAssignable to be reset to a prototype.");
+
+            if (policy != reset_policy::never)
+            {
+                m_prototype.reset(new _Tp(value));
+                m_reset_policy = policy;
             }
         }
 
         explicit
         impl(size_type count, const _Allocator& alloc = _Allocator())
-            :   m_managed_count(count),
-                m_capacity(count),
-                m_allocator(alloc)
+            :   m_managed_count(0),
+                m_hedged_count(0),
+                m_waiters(0),
+                m_creations(0),
+                m_max_creations(0),
+                m_reclaiming(0),
+                m_capacity(0),
+                m_allocator(alloc),
+                m_indexed_count(0),
+                m_parked_count(0),
+                m_parked_empty(0),
+                m_reset_policy(reset_policy::never),
+                m_reserved(0),
+                m_stats_slot(nullptr),
+                m_track_sites(false),
+                m_track_wear(false)
         {
-            for (size_type i = 0; i < m_managed_count; ++i)
+            this->reallocate(count);
+            for (; m_managed_count < count; ++m_managed_count)
             {
-                _Tp* obj = m_allocator.allocate(1);
+                _Tp* obj = m_allocated_space.top();
                 ::new((void *) (obj)) _Tp();
-                m_free_objects.push(obj);
+                m_allocated_space.pop();
+                this->push_free(obj);
             }
+            this->publish();
         }
 
         ~impl() // called until last shared ptr to *this has gone out of scope
         {
-            while (!m_free_objects.empty())
+            // Storage is freed a slab at a time. Objects only need to be
+            // visited when they have a non-trivial destructor.
+            remains rest(m_allocator);
+            if (!std::is_trivially_destructible<_Tp>::value)
             {
-                m_free_objects.top()->~_Tp();
-                m_allocated_space.push(m_free_objects.top());
-                m_free_objects.pop();
+                for (auto& parked : m_parked)
+                {
+                    if (parked.second)
+                        m_free_objects.push(parked.second);
+                }
+                for (auto& bucket : m_indexed)
+                {
+                    for (_Tp* obj : bucket.second)
+                        m_free_objects.push(obj);
+                }
+                rest.objects.swap(m_free_objects);
             }
+            rest.slabs.swap(m_slabs);
 
-            while (!m_allocated_space.empty())
+            if (m_reclaimer)
             {
-                m_allocator.deallocate(m_allocated_space.top(), 1);
-                m_allocated_space.top() = nullptr;
-                m_allocated_space.pop();
+                std::shared_ptr<remains> shared = std::make_shared<remains>(std::move(rest));
+                m_reclaimer([shared] (void) { shared->release(); });
+            }
+            else
+            {
+                rest.release();
             }
         }
 
@@ -525,187 +1604,784 @@ namespace carlosb
             scoped_lock_type pool_lock(m_pool_mutex);
 
             if (new_cap > m_capacity)
-            {
-                for (int i = m_capacity; i < new_cap; ++i)
-                    m_allocated_space.push(m_allocator.allocate(1));
-                m_capacity = new_cap;
-            }    
+                this->reallocate(new_cap);
         }
 
-        acquired_type acquire()
+        acquired_type acquire(tenant_type tenant)
         {   
-            scoped_lock_type pool_lock(m_pool_mutex);
+            _Tp* obj = nullptr;
+            prototype_ptr prototype;
+            deferred_work work;
+            {
+                scoped_lock_type pool_lock(m_pool_mutex);
+
+                if (this->may_acquire(tenant))
+                {
+                    obj = this->pop_free();
+                    this->account(tenant);
+                    prototype = this->prototype_for(reset_policy::on_acquire);
+                }
+                this->record_demand(work, obj == nullptr);
+                this->poll_watermarks(work);
+            }
 
-            if (m_free_objects.empty())
+            work();
+            if (!obj)
                 return acquired_object(none);
-            acquired_object obj(m_free_objects.top(), impl::shared_from_this());
-            m_free_objects.pop();
-            return std::move(obj);
+            return this->lend(obj, prototype, tenant);
         }
 
-        acquired_type acquire_wait(std::chrono::milliseconds time_limit)
+        std::vector<acquired_type> acquire_many(size_type count)
+        {
+            std::vector<_Tp*> objs;
+            prototype_ptr prototype;
+            deferred_work work;
+            {
+                scoped_lock_type pool_lock(m_pool_mutex);
+
+                size_type free = this->free_count();
+                bool enough = free >= count && free - count >= m_reserved;
+                if (enough)
+                {
+                    objs.reserve(count);
+                    for (size_type i = 0; i < count; ++i)
+                        objs.push_back(this->pop_free());
+                    prototype = this->prototype_for(reset_policy::on_acquire);
+                }
+                for (size_type i = 0; i < count; ++i)
+                    this->record_demand(work, !enough);
+                this->poll_watermarks(work);
+            }
+
+            work();
+            std::vector<acquired_type> leases;
+            leases.reserve(objs.size());
+            for (_Tp* obj : objs)
+                leases.push_back(acquired_object(obj, impl::shared_from_this()));
+
+            // should a reset throw, every lease returns its object as they unwind
+            if (prototype)
+            {
+                for (acquired_type& lease : leases)
+                    detail::reset_to(*lease, *prototype);
+            }
+            return leases;
+        }
+
+        acquired_type acquire_affine(affinity_type key)
+        {
+            _Tp* obj = nullptr;
+            prototype_ptr prototype;
+            deferred_work work;
+            {
+                scoped_lock_type pool_lock(m_pool_mutex);
+
+                if (this->may_acquire(no_tenant))
+                {
+                    obj = this->take_free(key);
+                    prototype = this->prototype_for(reset_policy::on_acquire);
+                }
+                this->record_demand(work, obj == nullptr);
+                this->poll_watermarks(work);
+            }
+
+            work();
+            if (!obj)
+                return acquired_object(none);
+            return this->lend(obj, prototype, no_tenant, key);
+        }
+
+        template <class _Predicate>
+        acquired_type acquire_if(_Predicate& pred)
+        {
+            _Tp* obj = nullptr;
+            prototype_ptr prototype;
+            deferred_work work;
+            {
+                scoped_lock_type pool_lock(m_pool_mutex);
+
+                if (this->may_acquire(no_tenant))
+                {
+                    obj = this->take_free_if(pred);
+                    if (obj)
+                        prototype = this->prototype_for(reset_policy::on_acquire);
+                }
+                this->record_demand(work, obj == nullptr);
+                this->poll_watermarks(work);
+            }
+
+            work();
+            if (!obj)
+                return acquired_object(none);
+            return this->lend(obj, prototype);
+        }
+
+        acquired_type acquire_where(index_key_type key)
+        {
+            _Tp* obj = nullptr;
+            prototype_ptr prototype;
+            deferred_work work;
+            {
+                scoped_lock_type pool_lock(m_pool_mutex);
+
+                typename std::unordered_map<index_key_type, std::vector<_Tp*>>::iterator it = m_indexed.find(key);
+                if (it != m_indexed.end() && this->may_acquire(no_tenant))
+                {
+                    obj = it->second.back();
+                    it->second.pop_back();
+                    if (it->second.empty())
+                        m_indexed.erase(it);
+                    --m_indexed_count;
+                    prototype = this->prototype_for(reset_policy::on_acquire);
+                }
+                this->record_demand(work, obj == nullptr);
+                this->poll_watermarks(work);
+            }
+
+            work();
+            if (!obj)
+                return acquired_object(none);
+            return this->lend(obj, prototype);
+        }
+
+        void set_index(key_extractor key_of)
+        {
+            scoped_lock_type pool_lock(m_pool_mutex);
+
+            for (auto& bucket : m_indexed)
+            {
+                for (_Tp* obj : bucket.second)
+                    m_free_objects.push(obj);
+            }
+            m_indexed.clear();
+            m_indexed_count = 0;
+            m_key_of = std::move(key_of);
+
+            if (m_key_of)
+            {
+                slot_stack free_objects;
+                free_objects.swap(m_free_objects);
+                for (; !free_objects.empty(); free_objects.pop())
+                    this->push_free(free_objects.top());
+            }
+        }
+
+        acquired_type acquire_wait(tenant_type tenant, affinity_type key, std::chrono::milliseconds time_limit)
         {   
             std::unique_lock<mutex_type> pool_lock(m_pool_mutex);
+            bool miss = !this->may_acquire(tenant);
+            std::chrono::steady_clock::time_point wait_start;
+            if (miss)
+            {
+                CARLOSB_PROBE1(wait_begin, this);
+                wait_start = std::chrono::steady_clock::now();
+            }
 
-            acquired_object obj;
+            // the lease is only constructed once the lock is released
+            _Tp* obj = nullptr;
+            ++m_waiters;
             if (time_limit == std::chrono::milliseconds::zero())
             {
-                m_objects_availabe.wait(pool_lock, [this] (void) { return !m_free_objects.empty(); });
+                m_objects_availabe.wait(pool_lock, [this, tenant] (void) { return this->may_acquire(tenant); });
                 
-                obj = acquired_object(m_free_objects.top(), impl::shared_from_this());
-                m_free_objects.pop();
+                obj = this->take_free(key);
+                this->account(tenant);
             }
             else
             {
-                if (m_objects_availabe.wait_for(pool_lock, time_limit, [this] (void) { return m_free_objects.empty(); }))
+                if (m_objects_availabe.wait_for(pool_lock, time_limit, [this, tenant] (void) { return this->may_acquire(tenant); }))
                 {
-                    obj = none;
-                }
-                else
-                {
-                    obj = acquired_object(m_free_objects.top(), impl::shared_from_this());
-                    m_free_objects.pop();
+                    obj = this->take_free(key);
+                    this->account(tenant);
                 }
             }
+            --m_waiters;
+            if (miss)
+            {
+                std::chrono::steady_clock::duration waited = std::chrono::steady_clock::now() - wait_start;
+                this->record_wait(waited);
+                CARLOSB_PROBE3(wait_end, this, obj != nullptr ? 1 : 0,
+                               std::chrono::duration_cast<std::chrono::nanoseconds>(waited).count());
+            }
 
+            prototype_ptr prototype = this->prototype_for(reset_policy::on_acquire);
+            deferred_work work;
+            this->record_demand(work, miss);
+            this->poll_watermarks(work);
             pool_lock.unlock();
             m_objects_availabe.notify_one();
 
-            return std::move(obj);
+            work();
+            if (!obj)
+                return acquired_object(none);
+            return this->lend(obj, prototype, tenant, key);
         }
 
         template <class... Args>
         acquired_type allocate(Args&&... args)
         {   
-            scoped_lock_type pool_lock(m_pool_mutex);
+            std::unique_lock<mutex_type> pool_lock(m_pool_mutex);
+            bool miss = !this->may_acquire(no_tenant);
 
-            if (m_free_objects.empty())
+            // wait for a free object or for a construction to finish
+            ++m_waiters;
+            m_objects_availabe.wait(pool_lock, [this] (void)
+            {
+                return this->may_acquire(no_tenant) || m_max_creations == 0 || m_creations < m_max_creations;
+            });
+            --m_waiters;
+
+            deferred_work work;
+            if (this->may_acquire(no_tenant))
+            {
+                _Tp* obj = this->pop_free();
+                prototype_ptr prototype = this->prototype_for(reset_policy::on_acquire);
+                this->record_demand(work, miss);
+                this->poll_watermarks(work);
+                pool_lock.unlock();
+
+                work();
+                return this->lend(obj, prototype);
+            }
+
+            this->record_demand(work, true);
+
+            // the slot is reserved under the lock, the object is constructed outside of it
+            _Tp* obj = this->take_space();
+            ++m_creations;
+            ++m_managed_count;
+            this->publish();
+            pool_lock.unlock();
+
+            try
             {
-                _Tp* obj = m_allocator.allocate(1);
                 ::new((void *) (obj)) _Tp(std::forward<Args>(args)...);
-                ++m_managed_count;
-                return acquired_object(obj, impl::shared_from_this());
             }
-            else
+            catch (...)
             {
-                acquired_object obj(m_free_objects.top(), impl::shared_from_this());
-                m_free_objects.pop();
-                return std::move(obj);
+                pool_lock.lock();
+                m_allocated_space.push(obj);
+                --m_managed_count;
+                --m_creations;
+                this->publish();
+                pool_lock.unlock();
+                m_objects_availabe.notify_all();
+                throw;
             }
+
+            pool_lock.lock();
+            --m_creations;
+            bool limited = m_max_creations > 0;
+            pool_lock.unlock();
+            if (limited)
+                m_objects_availabe.notify_all();
+
+            work();
+            return acquired_object(obj, impl::shared_from_this());
         }
 
+        template <class... Args>
+        acquired_type acquire_hedged(std::chrono::milliseconds wait_budget, size_type max_extra, Args&&... args)
+        {
+            std::unique_lock<mutex_type> pool_lock(m_pool_mutex);
+            bool miss = !this->may_acquire(no_tenant);
+
+            ++m_waiters;
+            bool available = m_objects_availabe.wait_for(pool_lock, wait_budget, [this] (void) { return this->may_acquire(no_tenant); });
+            --m_waiters;
+
+            deferred_work work;
+            if (available)
+            {
+                _Tp* obj = this->pop_free();
+                prototype_ptr prototype = this->prototype_for(reset_policy::on_acquire);
+                this->record_demand(work, miss);
+                this->poll_watermarks(work);
+                pool_lock.unlock();
+
+                work();
+                return this->lend(obj, prototype);
+            }
+
+            this->record_demand(work, true);
+            if (m_hedged_count >= max_extra || (m_max_creations > 0 && m_creations >= m_max_creations))
+            {
+                this->publish();
+                pool_lock.unlock();
+                work();
+                return acquired_object(none);
+            }
+
+            // the slot is reserved under the lock, the object is constructed outside of it
+            _Tp* obj = this->take_space();
+            ++m_hedged_count;
+            ++m_creations;
+            ++m_managed_count;
+            this->publish();
+            pool_lock.unlock();
+
+            try
+            {
+                ::new((void *) (obj)) _Tp(std::forward<Args>(args)...);
+            }
+            catch (...)
+            {
+                pool_lock.lock();
+                m_allocated_space.push(obj);
+                --m_hedged_count;
+                --m_creations;
+                --m_managed_count;
+                this->publish();
+                pool_lock.unlock();
+                m_objects_availabe.notify_all();
+                throw;
+            }
+
+            pool_lock.lock();
+            --m_creations;
+            bool limited = m_max_creations > 0;
+            pool_lock.unlock();
+            if (limited)
+                m_objects_availabe.notify_all();
+
+            work();
+            return acquired_object(obj, impl::shared_from_this());
+        }
 
         void push(const_reference value)
         {
-            scoped_lock_type pool_lock(m_pool_mutex);
+            deferred_work work;
+            {
+                scoped_lock_type pool_lock(m_pool_mutex);
 
-            if (m_managed_count == m_capacity)
-                this->reallocate(m_capacity * 2);
-            _Tp* obj = m_allocated_space.top();
-            m_allocated_space.pop();
-            ::new((void *) (obj)) _Tp(value);
-            m_free_objects.push(obj);
-            ++m_managed_count;
-            m_objects_availabe.notify_one();
+                _Tp* obj = this->take_space();
+                ::new((void *) (obj)) _Tp(value);
+                this->push_free(obj);
+                ++m_managed_count;
+                this->notify_free();
+                work = this->poll_watermarks();
+            }
+            work();
         }
 
         void push(rv_reference value)
         {
-            scoped_lock_type pool_lock(m_pool_mutex);
+            deferred_work work;
+            {
+                scoped_lock_type pool_lock(m_pool_mutex);
 
-            if (m_managed_count == m_capacity)
-                this->reallocate(m_capacity * 2);
-            _Tp* obj = m_allocated_space.top();
-            m_allocated_space.pop();
-            ::new((void *) (obj)) _Tp(std::move(value));
-            m_free_objects.push(obj);
-            ++m_managed_count;
-            m_objects_availabe.notify_one();
+                _Tp* obj = this->take_space();
+                ::new((void *) (obj)) _Tp(std::move(value));
+                this->push_free(obj);
+                ++m_managed_count;
+                this->notify_free();
+                work = this->poll_watermarks();
+            }
+            work();
         }
 
         template <class... Args>
         void emplace(Args&&... args)
         {
-            scoped_lock_type pool_lock(m_pool_mutex);
+            deferred_work work;
+            {
+                scoped_lock_type pool_lock(m_pool_mutex);
 
-            if (m_managed_count == m_capacity)
-                this->reallocate(m_capacity * 2);
-            _Tp* obj = m_allocated_space.top();
-            m_allocated_space.pop();
-            ::new((void *) (obj)) _Tp(std::forward<Args>(args)...);
-            m_free_objects.push(obj); 
-            ++m_managed_count;
-            m_objects_availabe.notify_one();
+                _Tp* obj = this->take_space();
+                ::new((void *) (obj)) _Tp(std::forward<Args>(args)...);
+                this->push_free(obj);
+                ++m_managed_count;
+                this->notify_free();
+                work = this->poll_watermarks();
+            }
+            work();
         }
 
         void resize(size_type count)
         {
-            scoped_lock_type pool_lock(m_pool_mutex);
+            std::unique_lock<mutex_type> pool_lock(m_pool_mutex);
 
-            size_type size = m_free_objects.size();
+            size_type size = this->free_count();
+            CARLOSB_PROBE3(resize, this, size, count);
             if (count > size)
             {
-                if (count > m_capacity)
-                    this->reallocate(count);
+                if (m_managed_count + count - size > m_capacity)
+                    this->reallocate(m_managed_count + count - size);
 
                 for (size_type i = size; i < count; ++i)
                 {
-                    _Tp* obj = m_allocated_space.top();
-                    m_allocated_space.pop();
-
+                    _Tp* obj = this->take_space();
                     ::new((void *) (obj)) _Tp();
-                    m_free_objects.push(obj);
+                    this->push_free(obj);
                 }
+                m_managed_count = m_managed_count + count - size;
+
+                deferred_work work = this->poll_watermarks();
+                pool_lock.unlock();
+                m_objects_availabe.notify_all();
+                work();
             }
             else
             {
-                for (size_type i = count; i < size; ++i)
-                {
-                    m_free_objects.top()->~_Tp();
-                    m_allocated_space.push(m_free_objects.top());
-                    m_free_objects.pop();
-                }
+                std::vector<_Tp*> surplus = this->take_surplus(size - count);
+                deferred_work work = this->poll_watermarks();
+                this->reclaim(std::move(surplus), pool_lock);
+                work();
             }
-            m_managed_count = count;
         }
 
         void resize(size_type count, const value_type& value)
         {
-            scoped_lock_type pool_lock(m_pool_mutex);
+            std::unique_lock<mutex_type> pool_lock(m_pool_mutex);
 
-            size_type size = m_free_objects.size();
+            size_type size = this->free_count();
+            CARLOSB_PROBE3(resize, this, size, count);
             if (count > size)
             {
-                if (count > m_capacity)
-                    this->reallocate(count);
+                if (m_managed_count + count - size > m_capacity)
+                    this->reallocate(m_managed_count + count - size);
 
                 for (size_type i = size; i < count; ++i)
                 {
-                    _Tp* obj = m_allocated_space.top();
-                    m_allocated_space.pop();
-
+                    _Tp* obj = this->take_space();
                     ::new((void *) (obj)) _Tp(value);
-                    m_free_objects.push(obj);
+                    this->push_free(obj);
                 }
+                m_managed_count = m_managed_count + count - size;
+
+                deferred_work work = this->poll_watermarks();
+                pool_lock.unlock();
+                m_objects_availabe.notify_all();
+                work();
             }
             else
             {
-                for (size_type i = count; i < size; ++i)
+                std::vector<_Tp*> surplus = this->take_surplus(size - count);
+                deferred_work work = this->poll_watermarks();
+                this->reclaim(std::move(surplus), pool_lock);
+                work();
+            }
+        }
+
+        void return_object(_Tp* obj, tenant_type tenant, affinity_type key)
+        {
+            assert(obj);
+            this->untrack_lease(obj);
+
+            std::unique_lock<mutex_type> pool_lock(m_pool_mutex);
+            prototype_ptr prototype = this->prototype_for(reset_policy::on_release);
+            if (prototype)
+            {
+                // the object is reset outside of the lock
+                pool_lock.unlock();
+                try
+                {
+                    detail::reset_to(*obj, *prototype);
+                }
+                catch (...)
                 {
-                    m_free_objects.top()->~_Tp();
-                    m_allocated_space.push(m_free_objects.top());
-                    m_free_objects.pop();
+                    // the object is in an unknown state, and the lease
+                    // releasing it cannot throw: drop it from the pool
+                    pool_lock.lock();
+                    this->retire(obj, tenant, pool_lock);
+                    return;
                 }
+                pool_lock.lock();
+            }
+            bump(m_counters.releases);
+            CARLOSB_PROBE2(release, this, obj);
+            if (tenant != no_tenant)
+                this->discharge(tenant);
+
+            if (m_hedged_count > 0 && m_waiters == 0)
+            {
+                // retire an extra object instead of keeping it around
+                --m_hedged_count;
+                --m_managed_count;
+                deferred_work work = this->poll_watermarks();
+                this->reclaim(std::vector<_Tp*>(1, obj), pool_lock);
+                work();
+                return;
+            }
+
+            if (key == no_affinity)
+            {
+                this->push_free(obj);
+            }
+            else
+            {
+                // park the object for the next acquisition under the same key
+                typename std::unordered_map<affinity_type, _Tp*>::iterator it = m_parked.find(key);
+                if (it == m_parked.end())
+                    it = m_parked.insert(std::make_pair(key, static_cast<_Tp*>(nullptr))).first;
+                else if (!it->second)
+                    --m_parked_empty;
+
+                if (it->second)
+                    this->push_free(it->second);
+                else
+                    ++m_parked_count;
+                it->second = obj;
             }
-            m_managed_count = count;
+            this->notify_free();
+            deferred_work work = this->poll_watermarks();
+            pool_lock.unlock();
+            work();
         }
 
-        void return_object(_Tp* obj)
+        void set_reclaimer(executor_type reclaimer)
         {
-            assert(obj);
             scoped_lock_type pool_lock(m_pool_mutex);
-            m_free_objects.push(obj);
-            m_objects_availabe.notify_one();
+            m_reclaimer = std::move(reclaimer);
+        }
+
+        void set_max_concurrent_creations(size_type limit)
+        {
+            {
+                scoped_lock_type pool_lock(m_pool_mutex);
+                m_max_creations = limit;
+            }
+            m_objects_availabe.notify_all();
+        }
+
+        void set_tenant_quota(tenant_type tenant, size_type max_outstanding, size_type guaranteed)
+        {
+            {
+                scoped_lock_type pool_lock(m_pool_mutex);
+
+                tenant_state& state = m_tenants[tenant];
+                m_reserved -= state.unmet();
+                state.max_outstanding   = max_outstanding;
+                state.guaranteed        = guaranteed;
+                m_reserved += state.unmet();
+            }
+            m_objects_availabe.notify_all();
+        }
+
+        size_type outstanding(tenant_type tenant) const
+        {
+            scoped_lock_type pool_lock(m_pool_mutex);
+
+            typename std::unordered_map<tenant_type, tenant_state, typename tenant_type::hash>::const_iterator it = m_tenants.find(tenant);
+            return it == m_tenants.end() ? 0 : it->second.outstanding;
+        }
+
+        void set_watermarks(size_type low, size_type high, size_type hysteresis,
+                            watermark_callback on_low, watermark_callback on_high)
+        {
+            if (low > high)
+                throw std::invalid_argument("object_pool::set_watermarks(): low must not be greater than high.");
+
+            std::unique_ptr<watermarks> marks(new watermarks);
+            marks->low          = low;
+            marks->high         = high;
+            marks->hysteresis   = hysteresis;
+            marks->on_low       = std::move(on_low);
+            marks->on_high      = std::move(on_high);
+            marks->below_low    = false;
+            marks->above_high   = false;
+
+            deferred_work work;
+            {
+                scoped_lock_type pool_lock(m_pool_mutex);
+                m_watermarks = std::move(marks);
+                work = this->poll_watermarks();
+            }
+            work();
+        }
+
+        void clear_watermarks()
+        {
+            std::unique_ptr<watermarks> marks;
+            scoped_lock_type pool_lock(m_pool_mutex);
+            m_watermarks.swap(marks);
+        }
+
+        void set_forecast(const forecast_policy& policy, executor_type executor)
+        {
+            static_assert(std::is_default_constructible<_Tp>::value,
+                          "T must be DefaultConstructible to grow the pool ahead of demand.");
+
+            if (policy.interval <= std::chrono::milliseconds::zero())
+                throw std::invalid_argument("object_pool::set_forecast(): interval must be positive.");
+            if (!(policy.smoothing > 0.0 && policy.smoothing <= 1.0))
+                throw std::invalid_argument("object_pool::set_forecast(): smoothing must be in (0, 1].");
+            if (!executor)
+                throw std::invalid_argument("object_pool::set_forecast(): executor must not be empty.");
+
+            std::unique_ptr<forecast> fc(new forecast);
+            fc->policy          = policy;
+            fc->executor        = std::move(executor);
+            fc->window_end      = std::chrono::steady_clock::now() + policy.interval;
+            fc->acquires        = 0;
+            fc->misses          = 0;
+            fc->acquire_average = 0.0;
+            fc->miss_average    = 0.0;
+            fc->growing         = false;
+
+            std::weak_ptr<impl> self = impl::shared_from_this();
+            fc->grow = [self] (size_type count)
+            {
+                if (std::shared_ptr<impl> pool = self.lock())
+                    pool->grow(count);
+            };
+
+            scoped_lock_type pool_lock(m_pool_mutex);
+            m_forecast = std::move(fc);
+        }
+
+        void clear_forecast()
+        {
+            std::unique_ptr<forecast> fc;
+            scoped_lock_type pool_lock(m_pool_mutex);
+            m_forecast.swap(fc);
+        }
+
+        void set_stats_slot(stats_slot* slot)
+        {
+            scoped_lock_type pool_lock(m_pool_mutex);
+            m_stats_slot = slot;
+            this->export_stats();
+        }
+
+        void set_site_tracking(bool enabled)
+        {
+            std::lock_guard<std::mutex> sites_lock(m_sites_mutex);
+            m_track_sites.store(enabled, std::memory_order_relaxed);
+            if (!enabled)
+                m_sites.clear();
+        }
+
+        void set_wear_tracking(bool enabled)
+        {
+            std::lock_guard<std::mutex> wear_lock(m_wear_mutex);
+            m_track_wear.store(enabled, std::memory_order_relaxed);
+            if (!enabled)
+                m_wear.clear();
+        }
+
+        /**
+         * Records the lease site and the use of `obj`, which is being lent.
+         */
+        inline void track_lease(_Tp* obj)
+        {
+            bool sites = m_track_sites.load(std::memory_order_relaxed);
+            bool wear = m_track_wear.load(std::memory_order_relaxed);
+            if (!sites && !wear)
+                return;
+
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            if (sites)
+            {
+                lease_record record;
+                record.site     = detail::current_lease_site();
+                record.since    = now;
+
+                std::lock_guard<std::mutex> sites_lock(m_sites_mutex);
+                if (m_track_sites.load(std::memory_order_relaxed))
+                    m_sites[obj] = record;
+            }
+            if (wear)
+            {
+                std::lock_guard<std::mutex> wear_lock(m_wear_mutex);
+                if (m_track_wear.load(std::memory_order_relaxed))
+                {
+                    slot_wear& slot = m_wear[obj];
+                    slot.slot           = obj;
+                    slot.last_acquired  = now;
+                    ++slot.acquisitions;
+                }
+            }
+        }
+
+        /**
+         * Forgets the lease site of `obj` and adds its hold time to the
+         * use of its slot, as it is being returned.
+         */
+        inline void untrack_lease(_Tp* obj)
+        {
+            if (m_track_sites.load(std::memory_order_relaxed))
+            {
+                std::lock_guard<std::mutex> sites_lock(m_sites_mutex);
+                m_sites.erase(obj);
+            }
+            if (m_track_wear.load(std::memory_order_relaxed))
+            {
+                std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+                std::lock_guard<std::mutex> wear_lock(m_wear_mutex);
+                typename std::unordered_map<_Tp*, slot_wear>::iterator it = m_wear.find(obj);
+                if (it != m_wear.end())
+                    it->second.held += now - it->second.last_acquired;
+            }
+        }
+
+        wear_report wear(size_type count) const
+        {
+            wear_report report;
+            std::vector<slot_wear> used;
+            {
+                scoped_lock_type pool_lock(m_pool_mutex);
+                report.slots = m_capacity;
+            }
+            {
+                std::lock_guard<std::mutex> wear_lock(m_wear_mutex);
+                used.reserve(m_wear.size());
+                for (const std::pair<_Tp* const, slot_wear>& slot : m_wear)
+                    used.push_back(slot.second);
+            }
+
+            // slots of a pool which has since shrunk may outnumber its capacity
+            report.never_used = used.size() < report.slots ? report.slots - used.size() : 0;
+            report.reuse.assign(1, report.never_used);
+            for (const slot_wear& slot : used)
+            {
+                size_type bucket = 1;
+                for (std::uint64_t n = slot.acquisitions; n > 1; n >>= 1)
+                    ++bucket;
+                if (report.reuse.size() <= bucket)
+                    report.reuse.resize(bucket + 1, 0);
+                ++report.reuse[bucket];
+            }
+
+            std::sort(used.begin(), used.end(), [] (const slot_wear& a, const slot_wear& b) {
+                return a.acquisitions > b.acquisitions;
+            });
+            size_type listed = std::min(count, used.size());
+            report.hottest.assign(used.begin(), used.begin() + listed);
+            report.coldest.assign(used.rbegin(), used.rbegin() + listed);
+            return report;
+        }
+
+        std::vector<site_usage> outstanding_by_site() const
+        {
+            std::map<std::string, site_usage> by_site;
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            {
+                std::lock_guard<std::mutex> sites_lock(m_sites_mutex);
+                for (const std::pair<_Tp* const, lease_record>& lease : m_sites)
+                {
+                    std::string site = lease.second.site ? lease.second.site : "<unknown>";
+                    std::chrono::steady_clock::duration age = now - lease.second.since;
+
+                    site_usage& usage = by_site[site];
+                    if (usage.outstanding == 0 || age > usage.oldest)
+                        usage.oldest = age;
+                    ++usage.outstanding;
+                }
+            }
+
+            std::vector<site_usage> usages;
+            usages.reserve(by_site.size());
+            for (std::pair<const std::string, site_usage>& entry : by_site)
+            {
+                entry.second.site = entry.first;
+                usages.push_back(std::move(entry.second));
+            }
+            std::stable_sort(usages.begin(), usages.end(), [] (const site_usage& a, const site_usage& b) {
+                return a.outstanding > b.outstanding;
+            });
+            return usages;
         }
 
         allocator_type get_allocator()
@@ -717,7 +2393,7 @@ namespace carlosb
         size_type size() const
         {
             scoped_lock_type pool_lock(m_pool_mutex);
-            return m_free_objects.size();
+            return this->free_count();
         }
 
         size_type managed_count() const
@@ -735,13 +2411,13 @@ namespace carlosb
         bool in_use() const
         {
             scoped_lock_type pool_lock(m_pool_mutex);
-            return (m_managed_count - m_free_objects.size()) > 0;
+            return (m_managed_count - this->free_count()) > 0;
         }
 
         bool empty() const
         {
             scoped_lock_type pool_lock(m_pool_mutex);
-            return m_free_objects.empty();
+            return this->free_count() == 0;
         }
 
         explicit
@@ -752,30 +2428,901 @@ namespace carlosb
 
         void swap(impl& other)
         {
+            if (this == &other)
+                return;
+
             scoped_lock_type lock_this(m_pool_mutex);
             scoped_lock_type lock_other(other.m_pool_mutex);
 
+            // lent objects return to the impl they came from, so its slabs
+            // must stay where they are while any object is out
+            if (!this->settled() || !other.settled())
+                throw std::logic_error("object_pool::swap(): Pools with objects in use cannot be swapped.");
+
             using std::swap;
             swap(m_managed_count, other.m_managed_count);
+            swap(m_hedged_count, other.m_hedged_count);
+            swap(m_max_creations, other.m_max_creations);
             swap(m_capacity, other.m_capacity);
             swap(m_free_objects, other.m_free_objects);
+            swap(m_parked, other.m_parked);
+            swap(m_parked_count, other.m_parked_count);
+            swap(m_parked_empty, other.m_parked_empty);
+            swap(m_indexed, other.m_indexed);
+            swap(m_indexed_count, other.m_indexed_count);
+            swap(m_key_of, other.m_key_of);
+            swap(m_allocated_space, other.m_allocated_space);
+            swap(m_slabs, other.m_slabs);
             swap(m_allocator, other.m_allocator);
+            swap(m_prototype, other.m_prototype);
+            swap(m_reset_policy, other.m_reset_policy);
+            swap(m_reclaimer, other.m_reclaimer);
+            swap(m_watermarks, other.m_watermarks);
+            swap(m_forecast, other.m_forecast);
+            swap(m_tenants, other.m_tenants);
+            swap(m_reserved, other.m_reserved);
+            m_counters.swap(other.m_counters);
+
+            counters::exchange(m_track_sites, other.m_track_sites);
+            counters::exchange(m_track_wear, other.m_track_wear);
+            {
+                std::lock_guard<std::mutex> wear_this(m_wear_mutex);
+                std::lock_guard<std::mutex> wear_other(other.m_wear_mutex);
+                swap(m_wear, other.m_wear);     // the use of slots follows their slabs
+            }
+
+            this->publish();
+            other.publish();
+        }
+
+        pool_metrics metrics() const
+        {
+            pool_metrics m;
+            m.acquisitions  = m_counters.acquisitions.load(std::memory_order_relaxed);
+            m.misses        = m_counters.misses.load(std::memory_order_relaxed);
+            m.releases      = m_counters.releases.load(std::memory_order_relaxed);
+            m_counters.load_waits(m);
+
+            size_type managed = m_counters.managed.load(std::memory_order_relaxed);
+            m.free          = m_counters.free.load(std::memory_order_relaxed);
+            m.in_use        = managed > m.free ? managed - m.free : 0;
+            m.capacity      = m_counters.capacity.load(std::memory_order_relaxed);
+            return m;
         }
 
     private:
+        using layout_type = detail::slot_layout<_Tp, _Allocator>;
+        using prototype_ptr = std::shared_ptr<const _Tp>;
+        using slot_stack = std::stack<_Tp*, std::vector<_Tp*>>;    ///< Stack backed by a vector, so it is freed in one go.
+
+        static constexpr size_type parked_slack = 64;   ///< Empty parking entries kept beyond the parked objects.
+
+        /**
+         * Contiguous block of storage from which slots are carved.
+         */
+        struct slab
+        {
+            _Tp*        block;      ///< Storage returned by the allocator.
+            size_type   length;     ///< Number of `T` requested to the allocator.
+        };
+
+        /**
+         * Allocates a single slab holding `new_cap - capacity()` slots. The
+         * slab is colored according to the number of slabs allocated so far.
+         */
         inline void reallocate(size_type new_cap)
         {
-            for (size_type i = m_capacity; i < new_cap; ++i)
-                m_allocated_space.push(m_allocator.allocate(1));
+            if (new_cap <= m_capacity)
+                return;
+
+            CARLOSB_PROBE3(grow, this, m_capacity, new_cap);
+            size_type count = new_cap - m_capacity;
+            size_type color = (m_slabs.size() % layout_type::colors) * layout_type::color_step;
+            size_type bytes = count * layout_type::stride + color;
+            if (layout_type::guaranteed < layout_type::alignment)
+                bytes += layout_type::alignment - layout_type::guaranteed;
+
+            slab s;
+            s.length    = (bytes + sizeof(_Tp) - 1) / sizeof(_Tp);
+            s.block     = m_allocator.allocate(s.length);
+            m_slabs.push_back(s);
+
+            std::uintptr_t first = detail::align_up(reinterpret_cast<std::uintptr_t>(s.block), layout_type::alignment) + color;
+
+            // pushed in reverse so that slots are handed out in address order
+            for (size_type i = count; i > 0; --i)
+                m_allocated_space.push(reinterpret_cast<_Tp*>(first + (i - 1) * layout_type::stride));
             m_capacity = new_cap;
+            this->publish();
+        }
+
+        /**
+         * Objects and storage which outlive the pool until they are
+         * released by the reclaimer.
+         */
+        struct remains
+        {
+            explicit
+            remains(const allocator_type& alloc)
+                : allocator(alloc)
+            {}
+
+            void release()
+            {
+                for (; !objects.empty(); objects.pop())
+                    objects.top()->~_Tp();
+                for (const slab& s : slabs)
+                    allocator.deallocate(s.block, s.length);
+                slabs.clear();
+            }
+
+            slot_stack          objects;
+            std::vector<slab>   slabs;
+            allocator_type      allocator;
+        };
+
+        /**
+         * Removes `count` free objects from the pool. Their slots remain
+         * unavailable until the objects are destroyed. Requires the lock.
+         */
+        inline std::vector<_Tp*> take_surplus(size_type count)
+        {
+            std::vector<_Tp*> surplus;
+            surplus.reserve(count);
+            for (; count > 0; --count)
+            {
+                surplus.push_back(this->pop_free());
+            }
+            m_managed_count -= surplus.size();
+            return surplus;
+        }
+
+        /**
+         * Destroys `surplus` after releasing `pool_lock`, either inline or
+         * through the reclaimer, and gives their slots back to the pool.
+         */
+        inline void reclaim(std::vector<_Tp*> surplus, std::unique_lock<mutex_type>& pool_lock)
+        {
+            executor_type reclaimer = m_reclaimer;
+            if (!surplus.empty())
+                ++m_reclaiming;
+            pool_lock.unlock();
+
+            if (surplus.empty())
+                return;
+
+            if (reclaimer)
+            {
+                std::shared_ptr<impl> self = impl::shared_from_this();
+                std::shared_ptr<std::vector<_Tp*>> objects = std::make_shared<std::vector<_Tp*>>(std::move(surplus));
+                reclaimer([self, objects] (void) { self->destroy(*objects); });
+            }
+            else
+            {
+                this->destroy(surplus);
+            }
+        }
+
+        /**
+         * Destroys `objects` and makes their slots available again.
+         */
+        inline void destroy(const std::vector<_Tp*>& objects)
+        {
+            if (!std::is_trivially_destructible<_Tp>::value)
+                for (_Tp* obj : objects)
+                    obj->~_Tp();
+
+            scoped_lock_type pool_lock(m_pool_mutex);
+            for (_Tp* obj : objects)
+                m_allocated_space.push(obj);
+            --m_reclaiming;
+        }
+
+        /**
+         * Watermarks and the side of them the pool is currently on.
+         */
+        struct watermarks
+        {
+            size_type           low;
+            size_type           high;
+            size_type           hysteresis;
+            watermark_callback  on_low;
+            watermark_callback  on_high;
+            bool                below_low;
+            bool                above_high;
+        };
+
+        /**
+         * Where and when a lent object was acquired.
+         */
+        struct lease_record
+        {
+            const char*                             site;
+            std::chrono::steady_clock::time_point   since;
+        };
+
+        /**
+         * Counters behind `metrics()`. They are only written with the lock
+         * held, so increments need no atomic read-modify-write, and are
+         * read without it. The wait histogram is written under a sequence
+         * lock, like a `stats_slot`, so that its count, buckets and sum are
+         * read together.
+         */
+        struct counters
+        {
+            counters()
+                :   sequence(0),
+                    acquisitions(0),
+                    misses(0),
+                    releases(0),
+                    waits(0),
+                    wait_nanoseconds(0),
+                    free(0),
+                    managed(0),
+                    capacity(0)
+            {
+                for (std::atomic<std::uint64_t>& bucket : wait_buckets)
+                    bucket.store(0, std::memory_order_relaxed);
+            }
+
+            std::atomic<std::uint64_t>  sequence;       ///< Odd while the wait histogram is being written.
+            std::atomic<std::uint64_t>  acquisitions;
+            std::atomic<std::uint64_t>  misses;
+            std::atomic<std::uint64_t>  releases;
+            std::atomic<std::uint64_t>  waits;
+            std::atomic<std::uint64_t>  wait_buckets[pool_metrics::wait_bucket_count];
+            std::atomic<std::uint64_t>  wait_nanoseconds;
+            std::atomic<size_type>      free;
+            std::atomic<size_type>      managed;
+            std::atomic<size_type>      capacity;
+
+            /**
+             * Starts a write of the wait histogram. Requires the lock.
+             */
+            void begin_write()
+            {
+                sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+            }
+
+            /**
+             * Ends a write of the wait histogram. Requires the lock.
+             */
+            void end_write()
+            {
+                sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+            }
+
+            /**
+             * Reads the wait histogram into `m`, retrying while it is being
+             * written.
+             */
+            void load_waits(pool_metrics& m) const
+            {
+                for (;;)
+                {
+                    std::uint64_t seq = sequence.load(std::memory_order_acquire);
+                    if (seq & 1)
+                    {
+                        std::this_thread::yield();
+                        continue;
+                    }
+
+                    m.waits         = waits.load(std::memory_order_relaxed);
+                    for (size_type i = 0; i < pool_metrics::wait_bucket_count; ++i)
+                        m.wait_buckets[i] = wait_buckets[i].load(std::memory_order_relaxed);
+                    m.wait_seconds  = wait_nanoseconds.load(std::memory_order_relaxed) * 1e-9;
+
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    if (sequence.load(std::memory_order_relaxed) == seq)
+                        return;
+                }
+            }
+
+            void swap(counters& other)
+            {
+                this->begin_write();
+                other.begin_write();
+                exchange(acquisitions, other.acquisitions);
+                exchange(misses, other.misses);
+                exchange(releases, other.releases);
+                exchange(waits, other.waits);
+                for (size_type i = 0; i < pool_metrics::wait_bucket_count; ++i)
+                    exchange(wait_buckets[i], other.wait_buckets[i]);
+                exchange(wait_nanoseconds, other.wait_nanoseconds);
+                exchange(free, other.free);
+                exchange(managed, other.managed);
+                exchange(capacity, other.capacity);
+                other.end_write();
+                this->end_write();
+            }
+
+            template <class _Up>
+            static void exchange(std::atomic<_Up>& a, std::atomic<_Up>& b)
+            {
+                b.store(a.exchange(b.load(std::memory_order_relaxed), std::memory_order_relaxed), std::memory_order_relaxed);
+            }
+        };
+
+        /**
+         * Increments a counter. Requires the lock.
+         */
+        template <class _Counter>
+        static inline void bump(std::atomic<_Counter>& counter, _Counter n = 1)
+        {
+            counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+
+        /**
+         * Publishes the counts of the pool to `metrics()`. Requires the lock.
+         */
+        inline void publish()
+        {
+            m_counters.free.store(this->free_count(), std::memory_order_relaxed);
+            m_counters.managed.store(m_managed_count, std::memory_order_relaxed);
+            m_counters.capacity.store(m_capacity, std::memory_order_relaxed);
+            this->export_stats();
+        }
+
+        /**
+         * Mirrors the counters into the stats slot, if any. Requires the lock.
+         */
+        inline void export_stats()
+        {
+            if (m_stats_slot)
+                m_stats_slot->store(this->metrics());
+        }
+
+        /**
+         * Counts a wait of `elapsed` in the wait histogram. Requires the lock.
+         */
+        inline void record_wait(std::chrono::steady_clock::duration elapsed)
+        {
+            std::uint64_t ns = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+            double seconds = ns * 1e-9;
+
+            m_counters.begin_write();
+            bump(m_counters.waits);
+            bump(m_counters.wait_nanoseconds, ns);
+            for (size_type i = 0; i < pool_metrics::wait_bucket_count; ++i)
+            {
+                if (seconds <= pool_metrics::wait_bucket_bound(i))
+                {
+                    bump(m_counters.wait_buckets[i]);
+                    break;
+                }
+            }
+            m_counters.end_write();
+        }
+
+        /**
+         * Stack of free objects which can be inspected in place.
+         */
+        struct free_stack : slot_stack
+        {
+            std::vector<_Tp*>& container()
+            {
+                return this->c;
+            }
+        };
+
+        /**
+         * Number of free objects, indexed and parked ones included. Requires
+         * the lock.
+         */
+        inline size_type free_count() const
+        {
+            return m_free_objects.size() + m_indexed_count + m_parked_count;
+        }
+
+        /**
+         * Adds a free object to the pool, indexing it if the pool is
+         * indexed. Requires the lock.
+         */
+        inline void push_free(_Tp* obj)
+        {
+            if (m_key_of)
+            {
+                m_indexed[m_key_of(*obj)].push_back(obj);
+                ++m_indexed_count;
+            }
+            else
+            {
+                m_free_objects.push(obj);
+            }
+        }
+
+        /**
+         * Removes the first free object satisfying `pred`, parked objects
+         * last. Requires the lock.
+         */
+        template <class _Predicate>
+        inline _Tp* take_free_if(_Predicate& pred)
+        {
+            std::vector<_Tp*>& objects = m_free_objects.container();
+            for (typename std::vector<_Tp*>::iterator it = objects.end(); it != objects.begin(); )
+            {
+                --it;
+                if (pred(static_cast<const _Tp&>(**it)))
+                {
+                    _Tp* obj = *it;
+                    objects.erase(it);
+                    return obj;
+                }
+            }
+
+            for (typename std::unordered_map<index_key_type, std::vector<_Tp*>>::iterator bucket = m_indexed.begin(); bucket != m_indexed.end(); ++bucket)
+            {
+                std::vector<_Tp*>& indexed = bucket->second;
+                for (typename std::vector<_Tp*>::iterator it = indexed.begin(); it != indexed.end(); ++it)
+                {
+                    if (pred(static_cast<const _Tp&>(**it)))
+                    {
+                        _Tp* obj = *it;
+                        indexed.erase(it);
+                        if (indexed.empty())
+                            m_indexed.erase(bucket);
+                        --m_indexed_count;
+                        return obj;
+                    }
+                }
+            }
+
+            for (typename std::unordered_map<affinity_type, _Tp*>::iterator it = m_parked.begin(); it != m_parked.end(); ++it)
+            {
+                if (it->second && pred(static_cast<const _Tp&>(*it->second)))
+                    return this->unpark(it);
+            }
+            return nullptr;
+        }
+
+        /**
+         * Removes a free object from the pool. Parked objects are only taken
+         * once no other object is free. Requires the lock.
+         */
+        inline _Tp* pop_free()
+        {
+            _Tp* obj;
+            if (!m_free_objects.empty())
+            {
+                obj = m_free_objects.top();
+                m_free_objects.pop();
+            }
+            else if (m_indexed_count > 0)
+            {
+                typename std::unordered_map<index_key_type, std::vector<_Tp*>>::iterator it = m_indexed.begin();
+                obj = it->second.back();
+                it->second.pop_back();
+                if (it->second.empty())
+                    m_indexed.erase(it);
+                --m_indexed_count;
+            }
+            else
+            {
+                typename std::unordered_map<affinity_type, _Tp*>::iterator it = m_parked.begin();
+                while (!it->second)
+                    ++it;
+                obj = this->unpark(it);
+            }
+            return obj;
+        }
+
+        /**
+         * Removes the object parked under `key` if any, a free object
+         * otherwise. Requires the lock.
+         */
+        inline _Tp* take_free(affinity_type key)
+        {
+            if (key != no_affinity)
+            {
+                typename std::unordered_map<affinity_type, _Tp*>::iterator it = m_parked.find(key);
+                if (it != m_parked.end() && it->second)
+                    return this->unpark(it);
+            }
+            return this->pop_free();
+        }
+
+        /**
+         * Takes the object parked at `it`. The entry is kept, so that parking
+         * under the same key again does not allocate, unless empty entries
+         * outnumber the parked objects by more than `parked_slack`; they are
+         * all dropped then. Requires the lock.
+         */
+        inline _Tp* unpark(typename std::unordered_map<affinity_type, _Tp*>::iterator it)
+        {
+            _Tp* obj = it->second;
+            it->second = nullptr;
+            --m_parked_count;
+            ++m_parked_empty;
+
+            if (m_parked_empty > m_parked_count + parked_slack)
+            {
+                for (it = m_parked.begin(); it != m_parked.end(); )
+                {
+                    if (it->second)
+                        ++it;
+                    else
+                        it = m_parked.erase(it);
+                }
+                m_parked_empty = 0;
+            }
+            return obj;
+        }
+
+        /**
+         * Quota and usage of a tenant.
+         */
+        struct tenant_state
+        {
+            tenant_state()
+                :   max_outstanding(static_cast<size_type>(-1)),
+                    guaranteed(0),
+                    outstanding(0)
+            {}
+
+            /**
+             * Number of objects still reserved for the tenant.
+             */
+            size_type unmet() const
+            {
+                return outstanding < guaranteed ? guaranteed - outstanding : 0;
+            }
+
+            size_type   max_outstanding;
+            size_type   guaranteed;
+            size_type   outstanding;
+        };
+
+        /**
+         * Whether a free object may be lent to `tenant`. Requires the lock.
+         */
+        inline bool may_acquire(tenant_type tenant) const
+        {
+            size_type free = this->free_count();
+            if (tenant == no_tenant || m_tenants.empty())
+                return free > m_reserved;
+
+            typename std::unordered_map<tenant_type, tenant_state, typename tenant_type::hash>::const_iterator it = m_tenants.find(tenant);
+            if (it == m_tenants.end())
+                return free > m_reserved;
+
+            const tenant_state& state = it->second;
+            return state.outstanding < state.max_outstanding && free + state.unmet() > m_reserved;
+        }
+
+        /**
+         * Wakes the waiters after an object has become free. With quotas,
+         * the first waiter may not be allowed to take it, so all are woken.
+         */
+        inline void notify_free()
+        {
+            if (m_tenants.empty())
+                m_objects_availabe.notify_one();
+            else
+                m_objects_availabe.notify_all();
+        }
+
+        /**
+         * Counts an object lent to `tenant`. Requires the lock.
+         */
+        inline void account(tenant_type tenant)
+        {
+            // tenants without a quota are not tracked
+            typename std::unordered_map<tenant_type, tenant_state, typename tenant_type::hash>::iterator it = m_tenants.find(tenant);
+            if (it == m_tenants.end())
+                return;
+
+            tenant_state& state = it->second;
+            m_reserved -= state.unmet();
+            ++state.outstanding;
+            m_reserved += state.unmet();
+        }
+
+        /**
+         * Counts an object returned by `tenant`. Requires the lock.
+         */
+        inline void discharge(tenant_type tenant)
+        {
+            typename std::unordered_map<tenant_type, tenant_state, typename tenant_type::hash>::iterator it = m_tenants.find(tenant);
+            if (it == m_tenants.end() || it->second.outstanding == 0)
+                return;     // acquired before the tenant had a quota
+
+            tenant_state& state = it->second;
+            m_reserved -= state.unmet();
+            --state.outstanding;
+            m_reserved += state.unmet();
+        }
+
+        /**
+         * State of the demand forecast.
+         */
+        struct forecast
+        {
+            forecast_policy                         policy;
+            executor_type                           executor;
+            std::function<void(size_type)>          grow;
+            std::chrono::steady_clock::time_point   window_end;
+            size_type                               acquires;           ///< Acquisitions in the current window.
+            size_type                               misses;             ///< Misses in the current window.
+            double                                  acquire_average;
+            double                                  miss_average;
+            bool                                    growing;            ///< Whether a growth task is in flight.
+        };
+
+        /**
+         * Work to be done once the pool mutex has been released.
+         */
+        struct deferred_work
+        {
+            void operator()() const
+            {
+                if (callback)
+                    callback(snapshot);
+                if (growth)
+                    executor(growth);
+            }
+
+            watermark_callback  callback;
+            pool_snapshot       snapshot;
+            executor_type       executor;
+            task_type           growth;
+        };
+
+        /**
+         * Counts an acquisition and, when the current window has ended,
+         * updates the forecast and schedules the growth it calls for.
+         * Requires the lock. The counters are exported by the `publish()`
+         * which must follow, so that an acquisition stores the stats slot
+         * once.
+         */
+        inline void record_demand(deferred_work& work, bool miss)
+        {
+            bump(m_counters.acquisitions);
+            if (miss)
+            {
+                bump(m_counters.misses);
+                CARLOSB_PROBE1(acquire_miss, this);
+            }
+            else
+            {
+                CARLOSB_PROBE2(acquire_hit, this, this->free_count());
+            }
+
+            if (!m_forecast)
+                return;
+
+            forecast& fc = *m_forecast;
+            ++fc.acquires;
+            if (miss)
+                ++fc.misses;
+
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            if (now < fc.window_end)
+                return;
+
+            double alpha    = fc.policy.smoothing;
+            double ramp     = fc.acquire_average > 0.0 ? fc.acquires / fc.acquire_average : 1.0;
+            fc.acquire_average  = alpha * fc.acquires + (1.0 - alpha) * fc.acquire_average;
+            fc.miss_average     = alpha * fc.misses + (1.0 - alpha) * fc.miss_average;
+            fc.acquires     = 0;
+            fc.misses       = 0;
+            fc.window_end   = now + fc.policy.interval;
+
+            double target = fc.policy.headroom * fc.miss_average * (ramp > 1.0 ? ramp : 1.0);
+            size_type wanted = static_cast<size_type>(target + 0.999999);
+            size_type free = this->free_count();
+            if (fc.growing || wanted <= free || m_managed_count >= fc.policy.max_size)
+                return;
+
+            size_type count = wanted - free;
+            if (count > fc.policy.max_size - m_managed_count)
+                count = fc.policy.max_size - m_managed_count;
+
+            std::function<void(size_type)> grow = fc.grow;
+            fc.growing      = true;
+            work.executor   = fc.executor;
+            work.growth     = [grow, count] (void) { grow(count); };
+        }
+
+        /**
+         * Adds `count` default-constructed objects to the pool. The objects
+         * are constructed without holding the lock.
+         */
+        void grow(size_type count)
+        {
+            std::vector<_Tp*> slots;
+            {
+                scoped_lock_type pool_lock(m_pool_mutex);
+                slots.reserve(count);
+                for (size_type i = 0; i < count; ++i)
+                    slots.push_back(this->take_space());
+            }
+
+            size_type constructed = 0;
+            try
+            {
+                for (; constructed < count; ++constructed)
+                    ::new((void *) (slots[constructed])) _Tp();
+            }
+            catch (...)
+            {
+                // nobody waits for the growth: keep the objects constructed
+                // so far and give the remaining slots back
+            }
+
+            deferred_work work;
+            {
+                scoped_lock_type pool_lock(m_pool_mutex);
+                for (size_type i = 0; i < count; ++i)
+                {
+                    if (i < constructed)
+                        this->push_free(slots[i]);
+                    else
+                        m_allocated_space.push(slots[i]);
+                }
+                m_managed_count += constructed;
+                if (m_forecast)
+                    m_forecast->growing = false;
+                work = this->poll_watermarks();
+            }
+            m_objects_availabe.notify_all();
+            work();
+        }
+
+        /**
+         * Updates the watermark state after the number of free objects has
+         * changed and returns the callback to invoke, if any. Requires the lock.
+         */
+        inline deferred_work poll_watermarks()
+        {
+            deferred_work work;
+            this->poll_watermarks(work);
+            return work;
+        }
+
+        /**
+         * Same as above, adding the callback to `work`, e.g. next to the
+         * growth scheduled by `record_demand()`.
+         */
+        inline void poll_watermarks(deferred_work& work)
+        {
+            this->publish();
+
+            if (!m_watermarks)
+                return;
+
+            watermarks& marks = *m_watermarks;
+            size_type free = this->free_count();
+
+            if (!marks.below_low && free < marks.low)
+            {
+                marks.below_low = true;
+                work.callback = marks.on_low;
+            }
+            else if (marks.below_low && free >= marks.low + marks.hysteresis)
+            {
+                marks.below_low = false;
+            }
+
+            if (!marks.above_high && free > marks.high)
+            {
+                marks.above_high = true;
+                work.callback = marks.on_high;
+            }
+            else if (marks.above_high && free + marks.hysteresis <= marks.high)
+            {
+                marks.above_high = false;
+            }
+
+            if (work.callback)
+            {
+                work.snapshot.free     = free;
+                work.snapshot.in_use   = m_managed_count - free;
+                work.snapshot.capacity = m_capacity;
+            }
+        }
+
+        /**
+         * Checks that no object is lent, being constructed or being
+         * destroyed, i.e. that every slot is in one of the stacks of the
+         * pool. Requires the lock.
+         */
+        inline bool settled() const
+        {
+            return m_managed_count == this->free_count() && m_creations == 0 && m_reclaiming == 0
+                && !(m_forecast && m_forecast->growing);
+        }
+
+        /**
+         * Returns the prototype if the pool resets objects at the moment
+         * given by `when`, `nullptr` otherwise. Requires the lock, since
+         * `swap()` exchanges prototypes.
+         */
+        inline prototype_ptr prototype_for(reset_policy when) const
+        {
+            return m_reset_policy == when ? m_prototype : prototype_ptr();
+        }
+
+        /**
+         * Lends `obj`, resetting it to `prototype` if any. Should the reset
+         * throw, the lease returns `obj` to the pool as it unwinds.
+         */
+        inline acquired_type lend(_Tp* obj, const prototype_ptr& prototype,
+                                  tenant_type tenant = no_tenant, affinity_type key = no_affinity)
+        {
+            acquired_object lease(obj, impl::shared_from_this(), tenant, key);
+            if (prototype)
+                detail::reset_to(*obj, *prototype);
+            return lease;
+        }
+
+        /**
+         * Destroys a released object instead of keeping it in the pool.
+         * Requires the lock, which is released.
+         */
+        inline void retire(_Tp* obj, tenant_type tenant, std::unique_lock<mutex_type>& pool_lock)
+        {
+            bump(m_counters.releases);
+            if (tenant != no_tenant)
+                this->discharge(tenant);
+            if (m_hedged_count > 0)
+                --m_hedged_count;
+            --m_managed_count;
+            deferred_work work = this->poll_watermarks();
+            this->reclaim(std::vector<_Tp*>(1, obj), pool_lock);
+            m_objects_availabe.notify_all();
+            work();
+        }
+
+        /**
+         * Returns uninitialized storage for one object, growing the pool if needed.
+         */
+        inline _Tp* take_space()
+        {
+            if (m_allocated_space.empty())
+                this->reallocate(m_capacity > 0 ? m_capacity * 2 : 1);
+            _Tp* obj = m_allocated_space.top();
+            m_allocated_space.pop();
+            return obj;
         }
 
         size_type                   m_managed_count;        ///< Number of objects currently in the pool.
+        size_type                   m_hedged_count;         ///< Number of extra objects constructed by acquire_hedged().
+        size_type                   m_waiters;              ///< Number of threads waiting for a free object.
+        size_type                   m_creations;            ///< Number of objects being constructed by allocate() or acquire_hedged().
+        size_type                   m_max_creations;        ///< Maximum number of concurrent constructions, zero if unlimited.
+        size_type                   m_reclaiming;           ///< Number of batches of surplus objects being destroyed.
         size_type                   m_capacity;             ///< Number of objects the pool can hold.
         allocator_type              m_allocator;            ///< Allocates space for the pool.
 
-        stack_type                  m_allocated_space;      ///< Pointer to first object in the pool.
-        stack_type                  m_free_objects;         ///< Stack of free objects.
+        slot_stack                  m_allocated_space;      ///< Stack of uninitialized slots.
+        free_stack                  m_free_objects;         ///< Stack of free objects.
+        std::unordered_map<affinity_type, _Tp*> m_parked;   ///< Free objects last released under a key, `nullptr` once taken.
+        std::unordered_map<index_key_type, std::vector<_Tp*>> m_indexed; ///< Free objects by index key.
+        size_type                   m_indexed_count;        ///< Number of indexed free objects.
+        size_type                   m_parked_count;         ///< Number of parked objects.
+        size_type                   m_parked_empty;         ///< Number of entries of `m_parked` without an object.
+        key_extractor               m_key_of;               ///< Computes index keys, if the pool is indexed.
+        std::vector<slab>           m_slabs;                ///< Storage owned by the pool.
+
+        prototype_ptr               m_prototype;            ///< Value objects are reset to.
+        reset_policy                m_reset_policy;         ///< When objects are reset.
+        executor_type               m_reclaimer;            ///< Destroys surplus objects.
+        std::unique_ptr<watermarks> m_watermarks;           ///< Watermarks, if any.
+        std::unique_ptr<forecast>   m_forecast;             ///< Demand forecast, if any.
+
+        std::unordered_map<tenant_type, tenant_state, typename tenant_type::hash> m_tenants; ///< Quotas and usage of the tenants.
+        size_type                   m_reserved;             ///< Free objects reserved by guarantees.
+        counters                    m_counters;             ///< Published counters.
+        stats_slot*                 m_stats_slot;           ///< Mirror of the counters, if any.
+
+        std::atomic<bool>           m_track_sites;          ///< Whether lease sites are recorded.
+        mutable std::mutex          m_sites_mutex;          ///< Guards the lease sites.
+        std::unordered_map<_Tp*, lease_record> m_sites;     ///< Lease sites of the lent objects.
+
+        std::atomic<bool>           m_track_wear;           ///< Whether the use of slots is counted.
+        mutable std::mutex          m_wear_mutex;           ///< Guards the use of slots.
+        std::unordered_map<_Tp*, slot_wear> m_wear;         ///< Use of the slots ever lent.
 
         mutable mutex_type          m_pool_mutex;           ///< Controls access to the pool.
         std::condition_variable     m_objects_availabe;     ///< Indicates presence of free objects.
@@ -790,8 +3337,10 @@ namespace carlosb
     class object_pool<_Tp, _Allocator, _Mutex>::deleter
     {
     public:
-        deleter(std::weak_ptr<impl> pool_ptr)
-            : m_pool_ptr(pool_ptr)
+        deleter(std::weak_ptr<impl> pool_ptr, tenant_type tenant = no_tenant, affinity_type key = no_affinity)
+            :   m_pool_ptr(pool_ptr),
+                m_tenant(tenant),
+                m_key(key)
         {}
 
         void operator()(_Tp* ptr)
@@ -799,11 +3348,13 @@ namespace carlosb
             if (ptr)
             {
                 if (auto pool = m_pool_ptr.lock())
-                    pool->return_object(ptr);
+                    pool->return_object(ptr, m_tenant, m_key);
             }
         }
     private:
         std::weak_ptr<impl> m_pool_ptr;
+        tenant_type         m_tenant;
+        affinity_type       m_key;
     };
 
     template <
@@ -815,29 +3366,43 @@ namespace carlosb
     {
     public:
         acquired_object()
-            : m_is_initialized(false)
+            :   m_obj(nullptr),
+                m_tenant(no_tenant),
+                m_key(no_affinity),
+                m_is_initialized(false)
         {}
 
         acquired_object(none_t)
-            : m_is_initialized(false)
+            :   m_obj(nullptr),
+                m_tenant(no_tenant),
+                m_key(no_affinity),
+                m_is_initialized(false)
         {}
 
         acquired_object(std::nullptr_t)
-            : m_is_initialized(false)
+            :   m_obj(nullptr),
+                m_tenant(no_tenant),
+                m_key(no_affinity),
+                m_is_initialized(false)
         {}
 
         explicit
-        acquired_object(_Tp* obj, std::shared_ptr<impl> lender)
+        acquired_object(_Tp* obj, std::shared_ptr<impl> lender, tenant_type tenant = no_tenant, affinity_type key = no_affinity)
             :   m_obj(obj),
                 m_pool(lender),
+                m_tenant(tenant),
+                m_key(key),
                 m_is_initialized(true)
         {
             assert(obj);
+            lender->track_lease(obj);
         }
 
         acquired_object(acquired_object&& other)
             :   m_obj(other.m_obj),
                 m_pool(std::move(other.m_pool)),
+                m_tenant(other.m_tenant),
+                m_key(other.m_key),
                 m_is_initialized(other.m_is_initialized)
         {
             other.m_obj = nullptr;
@@ -850,9 +3415,11 @@ namespace carlosb
         acquired_object& operator=(acquired_object&& other)
         {
             if (m_is_initialized)
-                object_pool::deleter{m_pool}(m_obj);
+                object_pool::deleter{m_pool, m_tenant, m_key}(m_obj);
 
             m_obj = other.m_obj;
+            m_tenant = other.m_tenant;
+            m_key = other.m_key;
             m_is_initialized = other.m_is_initialized;
 
             other.m_obj = nullptr;
@@ -866,7 +3433,7 @@ namespace carlosb
         acquired_object& operator=(none_t)
         {
             if (m_is_initialized)
-                object_pool::deleter{m_pool}(m_obj);
+                object_pool::deleter{m_pool, m_tenant, m_key}(m_obj);
 
             m_obj = nullptr;
             m_pool = nullptr;
@@ -878,7 +3445,7 @@ namespace carlosb
         ~acquired_object()
         {
             if (m_is_initialized)
-                object_pool::deleter{m_pool}(m_obj);
+                object_pool::deleter{m_pool, m_tenant, m_key}(m_obj);
         }
 
         _Tp& operator*() 
@@ -916,6 +3483,8 @@ namespace carlosb
     private:
         _Tp*                        m_obj;
         std::shared_ptr<impl>       m_pool;
+        tenant_type                 m_tenant;
+        affinity_type               m_key;
         bool                        m_is_initialized;
     };
 }
@@ -0,0 +1,266 @@
+/*
+ *  Copyright 2017 Carlos David Brito Pacheco
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ * 
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ * 
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef CARLOSB_OPENMETRICS_HPP
+#define CARLOSB_OPENMETRICS_HPP
+
+#include "object_pool.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace carlosb
+{
+    using named_metrics = std::vector<std::pair<std::string, pool_metrics>>;  ///< Counters of pools, by pool name.
+
+    namespace detail
+    {
+        /**
+         * Writes `value` escaped as an OpenMetrics label value.
+         */
+        inline void write_label_value(std::ostream& os, const std::string& value)
+        {
+            for (char c : value)
+            {
+                switch (c)
+                {
+                    case '\\':  os << "\\\\"; break;
+                    case '"':   os << "\\\""; break;
+                    case '\n':  os << "\\n"; break;
+                    default:    os << c;
+                }
+            }
+        }
+
+        /**
+         * Writes `value` as an OpenMetrics floating point number.
+         */
+        inline void write_double(std::ostream& os, double value)
+        {
+            std::ostringstream text;
+            text.precision(15);
+            text << value;
+            std::string str = text.str();
+            os << str;
+            if (str.find_first_of(".e") == std::string::npos)
+                os << ".0";
+        }
+
+        /**
+         * Writes the `# TYPE` line of a family and one sample per pool.
+         */
+        template <class _Getter>
+        inline void write_family(std::ostream& os, const named_metrics& pools, const char* family,
+                                 const char* type, const char* suffix, _Getter get)
+        {
+            os << "# TYPE " << family << ' ' << type << '\n';
+            for (const std::pair<std::string, pool_metrics>& pool : pools)
+            {
+                os << family << suffix << "{pool=\"";
+                write_label_value(os, pool.first);
+                os << "\"} " << get(pool.second) << '\n';
+            }
+        }
+    }
+
+    /**
+     * @brief      Writes the counters of `pools` in the OpenMetrics text
+     * format, terminated by `# EOF`.
+     *
+     * @param      os     Stream to write to.
+     * @param[in]  pools  Counters of the pools, labeled by pool name.
+     *
+     * Each metric family is written once, with one sample per pool labeled
+     * `pool="<name>"`.
+     */
+    inline void write_openmetrics(std::ostream& os, const named_metrics& pools)
+    {
+        detail::write_family(os, pools, "object_pool_acquisitions", "counter", "_total",
+                             [] (const pool_metrics& m) { return m.acquisitions; });
+        detail::write_family(os, pools, "object_pool_misses", "counter", "_total",
+                             [] (const pool_metrics& m) { return m.misses; });
+        detail::write_family(os, pools, "object_pool_releases", "counter", "_total",
+                             [] (const pool_metrics& m) { return m.releases; });
+        detail::write_family(os, pools, "object_pool_free", "gauge", "",
+                             [] (const pool_metrics& m) { return m.free; });
+        detail::write_family(os, pools, "object_pool_in_use", "gauge", "",
+                             [] (const pool_metrics& m) { return m.in_use; });
+        detail::write_family(os, pools, "object_pool_capacity", "gauge", "",
+                             [] (const pool_metrics& m) { return m.capacity; });
+
+        os << "# TYPE object_pool_wait_seconds histogram\n";
+        for (const std::pair<std::string, pool_metrics>& pool : pools)
+        {
+            const pool_metrics& m = pool.second;
+
+            std::uint64_t cumulative = 0;
+            for (std::size_t i = 0; i < pool_metrics::wait_bucket_count; ++i)
+            {
+                cumulative += m.wait_buckets[i];
+                os << "object_pool_wait_seconds_bucket{pool=\"";
+                detail::write_label_value(os, pool.first);
+                os << "\",le=\"";
+                detail::write_double(os, pool_metrics::wait_bucket_bound(i));
+                os << "\"} " << cumulative << '\n';
+            }
+
+            os << "object_pool_wait_seconds_bucket{pool=\"";
+            detail::write_label_value(os, pool.first);
+            os << "\",le=\"+Inf\"} " << m.waits << '\n';
+
+            os << "object_pool_wait_seconds_sum{pool=\"";
+            detail::write_label_value(os, pool.first);
+            os << "\"} ";
+            detail::write_double(os, m.wait_seconds);
+            os << '\n';
+
+            os << "object_pool_wait_seconds_count{pool=\"";
+            detail::write_label_value(os, pool.first);
+            os << "\"} " << m.waits << '\n';
+        }
+        os << "# EOF\n";
+    }
+
+    /**
+     * @brief      Writes the counters of `pool` in the OpenMetrics text
+     * format.
+     *
+     * @param      os    Stream to write to.
+     * @param[in]  name  Name of the pool, used as the `pool` label.
+     * @param[in]  pool  The pool.
+     */
+    template <class _Tp, class _Allocator, class _Mutex>
+    inline void write_openmetrics(std::ostream& os, const std::string& name, const object_pool<_Tp, _Allocator, _Mutex>& pool)
+    {
+        write_openmetrics(os, named_metrics(1, std::make_pair(name, pool.metrics())));
+    }
+
+    /**
+     * @brief      Set of named pools whose counters are written together.
+     *
+     * A scrape reads the counters of every registered pool, then writes
+     * them, so pools registered or removed meanwhile never show up half
+     * written. No pool lock is taken.
+     */
+    class metrics_registry
+    {
+    public:
+        using source_type = std::function<pool_metrics()>;     ///< Reads the counters of a pool.
+
+        /**
+         * @brief      Returns the registry shared by the whole process.
+         */
+        static metrics_registry& global()
+        {
+            static metrics_registry registry;
+            return registry;
+        }
+
+        /**
+         * @brief      Registers `pool` under `name`, replacing any pool of
+         * the same name.
+         *
+         * @param[in]  name  Name of the pool.
+         * @param[in]  pool  The pool. The registry shares it until it is
+         * removed.
+         */
+        template <class _Tp, class _Allocator, class _Mutex>
+        void add(const std::string& name, const object_pool<_Tp, _Allocator, _Mutex>& pool)
+        {
+            object_pool<_Tp, _Allocator, _Mutex> shared(pool);
+            this->add(name, source_type([shared] (void) { return shared.metrics(); }));
+        }
+
+        /**
+         * @brief      Registers a source of counters under `name`, replacing
+         * any source of the same name.
+         *
+         * @param[in]  name    Name of the pool.
+         * @param[in]  source  Reads the counters of the pool.
+         */
+        void add(const std::string& name, source_type source)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_sources[name] = std::move(source);
+        }
+
+        /**
+         * @brief      Removes the pool registered under `name`, if any.
+         *
+         * @param[in]  name  Name of the pool.
+         */
+        void remove(const std::string& name)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_sources.erase(name);
+        }
+
+        /**
+         * @brief      Writes the counters of every registered pool in the
+         * OpenMetrics text format, in order of name.
+         *
+         * @param      os    Stream to write to.
+         */
+        void write(std::ostream& os) const
+        {
+            named_metrics pools;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                pools.reserve(m_sources.size());
+                for (const std::pair<const std::string, source_type>& source : m_sources)
+                    pools.emplace_back(source.first, source.second());
+            }
+            write_openmetrics(os, pools);
+        }
+
+        /**
+         * @brief      Returns the counters of every registered pool in the
+         * OpenMetrics text format.
+         */
+        std::string scrape() const
+        {
+            std::ostringstream os;
+            this->write(os);
+            return os.str();
+        }
+
+    private:
+        mutable std::mutex                  m_mutex;    ///< Guards the sources.
+        std::map<std::string, source_type>  m_sources;  ///< Sources of counters, by pool name.
+    };
+}
+
+#endif
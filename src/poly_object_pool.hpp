@@ -0,0 +1,589 @@
+/*
+ *  Copyright 2017 Carlos David Brito Pacheco
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ * 
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ * 
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef CARLOSB_POLY_OBJECT_POOL_HPP
+#define CARLOSB_POLY_OBJECT_POOL_HPP
+
+#include "object_pool.hpp"
+
+#include <typeindex>
+#include <typeinfo>
+
+namespace carlosb
+{
+    /**
+     * @brief      Pool of objects of any type derived from `Base` which fits
+     * in `MaxSize` bytes aligned to `MaxAlign` bytes.
+     *
+     * Every object lives in a slot of the same size, so a single pool can
+     * serve a whole class hierarchy. Released objects are kept constructed
+     * in a free list of their own type and lent again to the next request
+     * for that type. When a type has no free object and every slot is
+     * constructed, a free object of another type is destroyed and its slot
+     * reused before the pool grows, so slots freed by one type are not
+     * stranded in its free list.
+     *
+     * @tparam     Base      Base class of the objects.
+     * @tparam     MaxSize   Size of a slot, in bytes.
+     * @tparam     MaxAlign  Alignment of a slot. Must be a power of two.
+     * @tparam     Mutex     Mutex guarding the pool.
+     */
+    template <
+        class _Base,
+        std::size_t _MaxSize,
+        std::size_t _MaxAlign = alignof(std::max_align_t),
+        class _Mutex = std::mutex
+    >
+    class poly_object_pool
+    {
+        static_assert((_MaxAlign & (_MaxAlign - 1)) == 0, "MaxAlign must be a power of two.");
+        static_assert(type_traits::is_lockable<_Mutex>::value,
+                      "Mutex template parameter must satisfy the Lockable requirement.");
+    private:
+        class impl;         ///< Contains the actual implementation of `poly_object_pool`.
+        struct type_entry;  ///< Free objects of one type.
+
+    public:
+        template <class _Up = _Base>
+        class acquired_object;
+
+        using base_type         = _Base;                    ///< Base class of the objects.
+        using size_type         = std::size_t;              ///< Size type used.
+        using mutex_type        = _Mutex;                   ///< Type of mutex.
+        using scoped_lock_type  = std::lock_guard<_Mutex>;  ///< Type of lock guard.
+
+        static constexpr std::size_t max_size  = _MaxSize;     ///< Maximum size of an object.
+        static constexpr std::size_t max_align = _MaxAlign;    ///< Maximum alignment of an object.
+
+        /**
+         * @brief      Constructs an empty pool.
+         */
+        poly_object_pool()
+            : m_pool(std::make_shared<impl>())
+        {}
+
+        /**
+         * @brief      Shares ownership of the objects.
+         *
+         * @param[in]  other  Other pool.
+         */
+        poly_object_pool(const poly_object_pool& other)
+            : m_pool(other.m_pool)
+        {}
+
+        /**
+         * @brief      Shares ownership of objects.
+         *
+         * @param[in]  other  Other pool.
+         *
+         * @return     Returns a reference to a pool object which manages
+         * the same objects as `other`.
+         */
+        poly_object_pool& operator=(const poly_object_pool& other)
+        {
+            m_pool = other.m_pool;
+            return *this;
+        }
+
+        /**
+         * @brief      Acquires a free `Derived`, or constructs one with
+         * `args` if there is none.
+         *
+         * @param[in]  args  Arguments forwarded to the constructor.
+         *
+         * @tparam     Derived  Type of the object.
+         *
+         * @return     Acquired object.
+         *
+         * A free object is lent as it was released: `args` are only used
+         * when a new object has to be constructed. The new object takes an
+         * unconstructed slot or, if there is none, the slot of a free object
+         * of another type, which is destroyed; the pool only grows when
+         * there are neither. Destruction and construction happen outside of
+         * the lock.
+         */
+        template <class _Derived, class... Args>
+        acquired_object<_Derived> emplace(Args&&... args)
+        {
+            return m_pool->template emplace<_Derived>(std::forward<Args>(args)...);
+        }
+
+        /**
+         * @brief      Acquires a free `Derived`.
+         *
+         * @tparam     Derived  Type of the object.
+         *
+         * @return     Acquired object, which is empty if the pool has no
+         * free `Derived`.
+         */
+        template <class _Derived>
+        acquired_object<_Derived> acquire()
+        {
+            return m_pool->template acquire<_Derived>();
+        }
+
+        /**
+         * @brief      Ensures there are slots for at least `new_cap` objects.
+         *
+         * @param[in]  new_cap  New capacity of the pool.
+         */
+        void reserve(size_type new_cap)
+        {
+            m_pool->reserve(new_cap);
+        }
+
+        /**
+         * @brief      Returns the number of free objects, of every type.
+         */
+        size_type size() const
+        {
+            return m_pool->size();
+        }
+
+        /**
+         * @brief      Returns the number of free objects of type `Derived`.
+         */
+        template <class _Derived>
+        size_type size() const
+        {
+            return m_pool->template size<_Derived>();
+        }
+
+        /**
+         * @brief      Returns the number of slots of the pool.
+         */
+        size_type capacity() const
+        {
+            return m_pool->capacity();
+        }
+
+        /**
+         * @brief      Checks if the pool has no free objects.
+         */
+        bool empty() const
+        {
+            return size() == 0;
+        }
+
+        /**
+         * @brief      Checks if any object is acquired.
+         */
+        bool in_use() const
+        {
+            return m_pool->in_use();
+        }
+
+    private:
+        std::shared_ptr<impl>       m_pool;                ///< Pointer to implementation of pool.
+    };
+
+    template <class _Base, std::size_t _MaxSize, std::size_t _MaxAlign, class _Mutex>
+    constexpr std::size_t poly_object_pool<_Base, _MaxSize, _MaxAlign, _Mutex>::max_size;
+
+    template <class _Base, std::size_t _MaxSize, std::size_t _MaxAlign, class _Mutex>
+    constexpr std::size_t poly_object_pool<_Base, _MaxSize, _MaxAlign, _Mutex>::max_align;
+
+    template <class _Base, std::size_t _MaxSize, std::size_t _MaxAlign, class _Mutex>
+    struct poly_object_pool<_Base, _MaxSize, _MaxAlign, _Mutex>::type_entry
+    {
+        explicit
+        type_entry(void* (*destroy_fn)(_Base*))
+            : destroy(destroy_fn)
+        {}
+
+        void*               (*destroy)(_Base*);    ///< Destroys an object of the type and returns its slot.
+        std::vector<_Base*> objects;               ///< Free objects of the type.
+    };
+
+    template <class _Base, std::size_t _MaxSize, std::size_t _MaxAlign, class _Mutex>
+    class poly_object_pool<_Base, _MaxSize, _MaxAlign, _Mutex>::impl
+        : public std::enable_shared_from_this<impl>
+    {
+        using slot_type         = typename std::aligned_storage<_MaxSize, _MaxAlign>::type;
+        using allocator_type    = cache_aligned_allocator<slot_type, _MaxAlign>;
+
+    public:
+        impl()
+            :   m_managed_count(0),
+                m_free_count(0),
+                m_capacity(0)
+        {}
+
+        impl(const impl&) = delete;
+        impl& operator=(const impl&) = delete;
+
+        ~impl() // called until last shared ptr to *this has gone out of scope
+        {
+            for (auto& type : m_types)
+            {
+                for (_Base* obj : type.second->objects)
+                    type.second->destroy(obj);
+            }
+
+            for (auto& slab : m_slabs)
+                m_allocator.deallocate(slab.first, slab.second);
+        }
+
+        template <class _Derived, class... Args>
+        acquired_object<_Derived> emplace(Args&&... args)
+        {
+            check_type<_Derived>();
+
+            void* slot = nullptr;
+            type_entry* entry = nullptr;
+            _Base* victim = nullptr;
+            type_entry* victim_entry = nullptr;
+            {
+                scoped_lock_type pool_lock(m_pool_mutex);
+
+                entry = this->template entry_for<_Derived>();
+                if (!entry->objects.empty())
+                {
+                    _Base* obj = entry->objects.back();
+                    entry->objects.pop_back();
+                    --m_free_count;
+                    return acquired_object<_Derived>(static_cast<_Derived*>(obj), entry, impl::shared_from_this());
+                }
+
+                if (m_allocated_space.empty() && (victim_entry = this->largest_free_list()))
+                {
+                    // the new object replaces a free object of another type
+                    victim = victim_entry->objects.back();
+                    victim_entry->objects.pop_back();
+                    --m_free_count;
+                }
+                else
+                {
+                    slot = this->take_space();
+                    ++m_managed_count;
+                }
+            }
+
+            if (victim)
+                slot = victim_entry->destroy(victim);
+
+            try
+            {
+                _Derived* obj = ::new(slot) _Derived(std::forward<Args>(args)...);
+                return acquired_object<_Derived>(obj, entry, impl::shared_from_this());
+            }
+            catch (...)
+            {
+                scoped_lock_type pool_lock(m_pool_mutex);
+                m_allocated_space.push_back(static_cast<slot_type*>(slot));
+                --m_managed_count;
+                throw;
+            }
+        }
+
+        template <class _Derived>
+        acquired_object<_Derived> acquire()
+        {
+            check_type<_Derived>();
+
+            scoped_lock_type pool_lock(m_pool_mutex);
+
+            type_entry* entry = this->template entry_for<_Derived>();
+            if (entry->objects.empty())
+                return acquired_object<_Derived>(none);
+
+            _Base* obj = entry->objects.back();
+            entry->objects.pop_back();
+            --m_free_count;
+            return acquired_object<_Derived>(static_cast<_Derived*>(obj), entry, impl::shared_from_this());
+        }
+
+        void return_object(_Base* obj, type_entry* entry)
+        {
+            assert(obj && entry);
+
+            scoped_lock_type pool_lock(m_pool_mutex);
+            entry->objects.push_back(obj);
+            ++m_free_count;
+        }
+
+        void reserve(size_type new_cap)
+        {
+            scoped_lock_type pool_lock(m_pool_mutex);
+            if (new_cap > m_capacity)
+                this->reallocate(new_cap);
+        }
+
+        size_type size() const
+        {
+            scoped_lock_type pool_lock(m_pool_mutex);
+            return m_free_count;
+        }
+
+        template <class _Derived>
+        size_type size() const
+        {
+            scoped_lock_type pool_lock(m_pool_mutex);
+
+            typename std::unordered_map<std::type_index, std::unique_ptr<type_entry>>::const_iterator it = m_types.find(typeid(_Derived));
+            return it == m_types.end() ? 0 : it->second->objects.size();
+        }
+
+        size_type capacity() const
+        {
+            scoped_lock_type pool_lock(m_pool_mutex);
+            return m_capacity;
+        }
+
+        bool in_use() const
+        {
+            scoped_lock_type pool_lock(m_pool_mutex);
+            return m_managed_count > m_free_count;
+        }
+
+    private:
+        template <class _Derived>
+        static void check_type()
+        {
+            static_assert(std::is_base_of<_Base, _Derived>::value, "Derived must derive from Base.");
+            static_assert(sizeof(_Derived) <= _MaxSize, "Derived does not fit in a slot, increase MaxSize.");
+            static_assert(alignof(_Derived) <= _MaxAlign, "Derived is over-aligned for a slot, increase MaxAlign.");
+        }
+
+        template <class _Derived>
+        static void* destroy(_Base* obj)
+        {
+            _Derived* derived = static_cast<_Derived*>(obj);
+            derived->~_Derived();
+            return derived;
+        }
+
+        /**
+         * Returns the free list holding the most objects, or `nullptr` if
+         * there are no free objects. Requires the lock.
+         */
+        inline type_entry* largest_free_list()
+        {
+            type_entry* largest = nullptr;
+            if (m_free_count == 0)
+                return largest;
+
+            for (auto& type : m_types)
+            {
+                if (!largest || type.second->objects.size() > largest->objects.size())
+                    largest = type.second.get();
+            }
+            return largest;
+        }
+
+        /**
+         * Returns the free list of `Derived`, creating it on first use.
+         * Requires the lock.
+         */
+        template <class _Derived>
+        inline type_entry* entry_for()
+        {
+            std::unique_ptr<type_entry>& entry = m_types[typeid(_Derived)];
+            if (!entry)
+                entry.reset(new type_entry(&impl::template destroy<_Derived>));
+            return entry.get();
+        }
+
+        /**
+         * Takes an unconstructed slot, growing the pool if there is none.
+         * Requires the lock.
+         */
+        inline void* take_space()
+        {
+            if (m_allocated_space.empty())
+                this->reallocate(m_capacity > 0 ? 2 * m_capacity : 1);
+
+            slot_type* slot = m_allocated_space.back();
+            m_allocated_space.pop_back();
+            return slot;
+        }
+
+        /**
+         * Adds a slab of `new_cap - m_capacity` slots. Requires the lock.
+         */
+        inline void reallocate(size_type new_cap)
+        {
+            assert(new_cap > m_capacity);
+
+            size_type length = new_cap - m_capacity;
+            slot_type* block = m_allocator.allocate(length);
+            m_slabs.emplace_back(block, length);
+
+            m_allocated_space.reserve(m_allocated_space.size() + length);
+            for (size_type i = length; i > 0; --i)
+                m_allocated_space.push_back(block + (i - 1));
+            m_capacity = new_cap;
+        }
+
+        size_type                   m_managed_count;        ///< Number of constructed objects.
+        size_type                   m_free_count;           ///< Number of free objects.
+        size_type                   m_capacity;             ///< Number of slots.
+        allocator_type              m_allocator;            ///< Allocates the slabs.
+
+        std::vector<slot_type*>     m_allocated_space;      ///< Unconstructed slots.
+        std::vector<std::pair<slot_type*, size_type>> m_slabs; ///< Storage owned by the pool.
+        std::unordered_map<std::type_index, std::unique_ptr<type_entry>> m_types; ///< Free objects by type.
+
+        mutable mutex_type          m_pool_mutex;           ///< Controls access to the pool.
+    };
+
+    template <class _Base, std::size_t _MaxSize, std::size_t _MaxAlign, class _Mutex>
+    template <class _Up>
+    class poly_object_pool<_Base, _MaxSize, _MaxAlign, _Mutex>::acquired_object
+    {
+        template <class _Vp>
+        friend class acquired_object;
+
+    public:
+        acquired_object()
+            :   m_obj(nullptr),
+                m_entry(nullptr)
+        {}
+
+        acquired_object(none_t)
+            :   m_obj(nullptr),
+                m_entry(nullptr)
+        {}
+
+        acquired_object(std::nullptr_t)
+            :   m_obj(nullptr),
+                m_entry(nullptr)
+        {}
+
+        explicit
+        acquired_object(_Up* obj, type_entry* entry, std::shared_ptr<impl> lender)
+            :   m_obj(obj),
+                m_entry(entry),
+                m_pool(std::move(lender))
+        {
+            assert(obj && entry);
+        }
+
+        acquired_object(acquired_object&& other)
+            :   m_obj(other.m_obj),
+                m_entry(other.m_entry),
+                m_pool(std::move(other.m_pool))
+        {
+            other.m_obj = nullptr;
+            other.m_entry = nullptr;
+        }
+
+        /**
+         * @brief      Converts an object acquired as a derived type into one
+         * of a base type. It still returns to the free list of its
+         * dynamic type.
+         */
+        template <class _Vp, class = typename std::enable_if<std::is_convertible<_Vp*, _Up*>::value>::type>
+        acquired_object(acquired_object<_Vp>&& other)
+            :   m_obj(other.m_obj),
+                m_entry(other.m_entry),
+                m_pool(std::move(other.m_pool))
+        {
+            other.m_obj = nullptr;
+            other.m_entry = nullptr;
+        }
+
+        acquired_object(const acquired_object&) = delete;
+        acquired_object& operator=(const acquired_object&) = delete;
+
+        acquired_object& operator=(acquired_object&& other)
+        {
+            this->release();
+
+            m_obj = other.m_obj;
+            m_entry = other.m_entry;
+            m_pool = std::move(other.m_pool);
+
+            other.m_obj = nullptr;
+            other.m_entry = nullptr;
+
+            return *this;
+        }
+
+        acquired_object& operator=(none_t)
+        {
+            this->release();
+            return *this;
+        }
+
+        ~acquired_object()
+        {
+            this->release();
+        }
+
+        _Up& operator*()
+        {
+            if (!m_obj)
+                throw std::logic_error("acquired_object::operator*(): Initialization is required for data access.");
+            else
+                return *m_obj;
+        }
+
+        _Up* operator->()
+        {
+            if (!m_obj)
+                throw std::logic_error("acquired_object::operator->(): Initialization is required for data access.");
+            else
+                return m_obj;
+        }
+
+        bool operator==(const none_t) const
+        {
+            return m_obj == nullptr;
+        }
+
+        bool operator!=(const none_t) const
+        {
+            return !(*this == none);
+        }
+
+        explicit
+        operator bool() const
+        {
+            return m_obj != nullptr;
+        }
+
+    private:
+        void release()
+        {
+            if (m_obj)
+                m_pool->return_object(static_cast<_Base*>(m_obj), m_entry);
+
+            m_obj = nullptr;
+            m_entry = nullptr;
+            m_pool = nullptr;
+        }
+
+        _Up*                        m_obj;
+        type_entry*                 m_entry;
+        std::shared_ptr<impl>       m_pool;
+    };
+}
+
+#endif
@@ -0,0 +1,184 @@
+/*
+ *  Copyright 2017 Carlos David Brito Pacheco
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ * 
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ * 
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef CARLOSB_POOL_CHAIN_HPP
+#define CARLOSB_POOL_CHAIN_HPP
+
+#include "object_pool.hpp"
+
+#include <chrono>
+#include <initializer_list>
+#include <vector>
+
+namespace carlosb
+{
+    /**
+     * @brief      Acquires objects from a sequence of pools, in order of
+     * preference.
+     *
+     * Each acquisition is tried on the first pool, then on the second one
+     * and so on until one of them lends an object. Acquired objects are the
+     * ones of the pool that lent them and return to that pool when released.
+     *
+     * The chain shares ownership of its pools, as copies of an `object_pool`
+     * do. Pools may be acquired from concurrently, but the chain itself must
+     * not be modified while it is used by other threads.
+     */
+    template <
+        class _Tp,
+        class _Allocator = std::allocator<_Tp>,
+        class _Mutex = std::mutex
+    >
+    class pool_chain
+    {
+    public:
+        using pool_type         = object_pool<_Tp, _Allocator, _Mutex>;    ///< Type of the chained pools.
+        using acquired_type     = typename pool_type::acquired_type;        ///< Type of acquired objects.
+        using tenant_type       = typename pool_type::tenant_type;          ///< Identifies the tenants sharing a pool.
+        using size_type         = std::size_t;                              ///< Size type used.
+
+        /**
+         * @brief      Constructs an empty chain.
+         */
+        pool_chain() = default;
+
+        /**
+         * @brief      Constructs a chain of `pools`, the first being the
+         * preferred one.
+         *
+         * @param[in]  pools  The pools.
+         */
+        pool_chain(std::initializer_list<pool_type> pools)
+            : m_pools(pools)
+        {}
+
+        /**
+         * @brief      Appends `pool` to the chain, after every other pool.
+         *
+         * @param[in]  pool  The pool.
+         */
+        void push_back(const pool_type& pool)
+        {
+            m_pools.push_back(pool);
+        }
+
+        /**
+         * @brief      Acquires an object from the first pool which has one.
+         *
+         * @return     Acquired object, which is empty if no pool has a free
+         * object.
+         *
+         * Complexity
+         * ----------
+         * Linear in the number of pools.
+         */
+        acquired_type acquire()
+        {
+            for (pool_type& pool : m_pools)
+            {
+                if (acquired_type obj = pool.acquire())
+                    return obj;
+            }
+            return acquired_type(none);
+        }
+
+        /**
+         * @brief      Acquires an object on behalf of `tenant` from the first
+         * pool which lends it one.
+         *
+         * @param[in]  tenant  Tenant the object is lent to.
+         *
+         * @return     Acquired object, which is empty if no pool lends one.
+         */
+        acquired_type acquire(tenant_type tenant)
+        {
+            for (pool_type& pool : m_pools)
+            {
+                if (acquired_type obj = pool.acquire(tenant))
+                    return obj;
+            }
+            return acquired_type(none);
+        }
+
+        /**
+         * @brief      Acquires an object from the first pool which has one,
+         * or waits on the last pool until it has one or the `time_limit` has
+         * ran out.
+         *
+         * @param[in]  time_limit  Maximum waiting time, zero meaning no limit.
+         *
+         * @return     Acquired object.
+         *
+         * The last pool is the pool of last resort, hence the one waited on.
+         * Objects released to other pools meanwhile are not considered.
+         */
+        acquired_type acquire_wait(std::chrono::milliseconds time_limit = std::chrono::milliseconds::zero())
+        {
+            if (m_pools.empty())
+                return acquired_type(none);
+
+            if (acquired_type obj = this->acquire())
+                return obj;
+            return m_pools.back().acquire_wait(time_limit);
+        }
+
+        /**
+         * @brief      Returns the pool at `pos` in the chain.
+         *
+         * @param[in]  pos   Position of the pool, zero being the preferred one.
+         *
+         * @return     Reference to the pool.
+         */
+        pool_type& operator[](size_type pos)
+        {
+            return m_pools[pos];
+        }
+
+        /**
+         * @brief      Returns the number of chained pools.
+         */
+        size_type size() const
+        {
+            return m_pools.size();
+        }
+
+        /**
+         * @brief      Checks if the chain has no pool.
+         */
+        bool empty() const
+        {
+            return m_pools.empty();
+        }
+
+    private:
+        std::vector<pool_type>      m_pools;               ///< Chained pools, in order of preference.
+    };
+}
+
+#endif
@@ -0,0 +1,226 @@
+/*
+ *  Copyright 2017 Carlos David Brito Pacheco
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ * 
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ * 
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef CARLOSB_POOLED_EXECUTOR_HPP
+#define CARLOSB_POOLED_EXECUTOR_HPP
+
+#include "object_pool.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace carlosb
+{
+    /**
+     * @brief      Runs tasks on worker threads, each task borrowing a
+     * context object from an `object_pool`.
+     *
+     * A worker acquires a context from the pool before running its first
+     * task and keeps it for the following ones while there is work queued.
+     * It releases the context back to the pool when the queue runs dry, so
+     * contexts are only held by busy workers. Contexts are acquired with
+     * `acquire_affine_wait()` keyed by the index of the worker, so a worker
+     * gets its own context back after idling unless the pool had to lend
+     * it elsewhere. Contexts are therefore reused without being
+     * constructed, copied or allocated for: the pool should hold at least as many contexts as there
+     * are workers, otherwise workers wait for one.
+     *
+     * Tasks are run in the order they were submitted, by whichever worker is
+     * free. A task must not throw. The destructor runs every pending task
+     * before joining the workers.
+     *
+     * @tparam     Context  Type of the contexts.
+     * @tparam     Pool     Type of the pool of contexts.
+     */
+    template <
+        class _Context,
+        class _Pool = object_pool<_Context>
+    >
+    class pooled_executor
+    {
+    public:
+        using context_type      = _Context;                             ///< Type of the contexts.
+        using pool_type         = _Pool;                                ///< Type of the pool of contexts.
+        using task_type         = std::function<void(_Context&)>;       ///< Type of the tasks.
+        using size_type         = std::size_t;                          ///< Size type used.
+
+        /**
+         * @brief      Starts `workers` threads borrowing contexts from
+         * `contexts`.
+         *
+         * @param[in]  contexts  Pool of contexts. The executor shares it.
+         * @param[in]  workers   Number of worker threads, at least one.
+         */
+        pooled_executor(const pool_type& contexts, size_type workers)
+            : m_state(std::make_shared<state>(contexts))
+        {
+            if (workers == 0)
+                workers = 1;
+
+            std::shared_ptr<state> st = m_state;
+            m_workers.reserve(workers);
+            for (size_type i = 0; i < workers; ++i)
+                m_workers.emplace_back([st, i] (void) { st->run(i); });
+        }
+
+        pooled_executor(const pooled_executor&) = delete;
+        pooled_executor& operator=(const pooled_executor&) = delete;
+
+        /**
+         * @brief      Runs the pending tasks and joins the workers.
+         */
+        ~pooled_executor()
+        {
+            m_state->stop();
+            for (std::thread& worker : m_workers)
+                worker.join();
+        }
+
+        /**
+         * @brief      Queues a task.
+         *
+         * @param[in]  task  Task to be run with a context.
+         */
+        void submit(task_type task)
+        {
+            m_state->submit(std::move(task));
+        }
+
+        /**
+         * @brief      Blocks until every task submitted so far has been run
+         * and its context returned to the pool.
+         */
+        void wait_idle()
+        {
+            m_state->wait_idle();
+        }
+
+        /**
+         * @brief      Returns the number of worker threads.
+         */
+        size_type workers() const
+        {
+            return m_workers.size();
+        }
+
+    private:
+        struct state
+        {
+            explicit
+            state(const pool_type& contexts)
+                :   pool(contexts),
+                    pending(0),
+                    stopped(false)
+            {}
+
+            void submit(task_type task)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    tasks.push_back(std::move(task));
+                    ++pending;
+                }
+                task_available.notify_one();
+            }
+
+            void run(size_type worker)
+            {
+                typename pool_type::acquired_type context;  // cached while there is work
+                std::size_t completed = 0;                  // tasks run with the cached context
+
+                std::unique_lock<std::mutex> lock(mutex);
+                for (;;)
+                {
+                    if (tasks.empty() && context)
+                    {
+                        lock.unlock();
+                        context = none;
+                        lock.lock();
+
+                        // tasks only count as done once their context is back
+                        pending -= completed;
+                        completed = 0;
+                        if (pending == 0)
+                            idle.notify_all();
+                        continue;
+                    }
+
+                    task_available.wait(lock, [this] (void) { return stopped || !tasks.empty(); });
+                    if (tasks.empty())
+                        return;
+
+                    task_type task = std::move(tasks.front());
+                    tasks.pop_front();
+                    lock.unlock();
+
+                    if (!context)
+                        context = pool.acquire_affine_wait(worker);
+                    task(*context);
+                    task = nullptr;
+
+                    lock.lock();
+                    ++completed;
+                }
+            }
+
+            void stop()
+            {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    stopped = true;
+                }
+                task_available.notify_all();
+            }
+
+            void wait_idle()
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                idle.wait(lock, [this] (void) { return pending == 0; });
+            }
+
+            pool_type                   pool;
+            std::mutex                  mutex;
+            std::condition_variable     task_available;
+            std::condition_variable     idle;
+            std::deque<task_type>       tasks;
+            std::size_t                 pending;
+            bool                        stopped;
+        };
+
+        std::shared_ptr<state>      m_state;    ///< State shared with the workers.
+        std::vector<std::thread>    m_workers;  ///< Worker threads.
+    };
+}
+
+#endif
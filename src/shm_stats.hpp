@@ -0,0 +1,352 @@
+/*
+ *  Copyright 2017 Carlos David Brito Pacheco
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ * 
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ * 
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef CARLOSB_SHM_STATS_HPP
+#define CARLOSB_SHM_STATS_HPP
+
+#include "object_pool.hpp"
+#include "openmetrics.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace carlosb
+{
+    namespace detail
+    {
+        static_assert(ATOMIC_LLONG_LOCK_FREE == 2,
+                      "Counters in shared memory require lock-free 64 bit atomics.");
+
+        /**
+         * A pool in a stats page. `state` is odd while the entry is in use
+         * and is bumped on every change of owner, so readers can tell
+         * whether the name they copied belongs to the counters they read.
+         */
+        struct shm_stats_entry
+        {
+            static constexpr std::size_t name_size = 48;    ///< Size of the name, including the terminator.
+
+            std::atomic<std::uint32_t>  state;
+            char                        name[name_size];
+            stats_slot                  stats;
+
+            shm_stats_entry()
+                :   state(0)
+            {
+                std::memset(name, 0, name_size);
+            }
+        };
+
+        /**
+         * Layout of a stats page.
+         */
+        struct shm_stats_layout
+        {
+            static constexpr std::uint64_t  magic_value = 0x6f626a706f6f6c31;  ///< "objpool1".
+            static constexpr std::uint32_t  version_value = 1;                 ///< Version of the layout.
+            static constexpr std::size_t    entry_count = 64;                  ///< Number of pools per page.
+
+            std::atomic<std::uint64_t>  magic;      ///< Set once the page is initialized.
+            std::uint32_t               version;
+            std::uint32_t               count;
+            shm_stats_entry             entries[entry_count];
+
+            shm_stats_layout()
+                :   magic(0),
+                    version(version_value),
+                    count(entry_count)
+            {}
+        };
+    }
+
+    /**
+     * @brief      Page of shared memory to which pools publish their
+     * counters, so other processes can inspect them.
+     *
+     * The page is created under `/dev/shm` and removed by the destructor.
+     * Attached pools write their counters into it once per acquisition and
+     * release, with relaxed atomic stores under a sequence lock; nothing
+     * else is done on their hot path. `shm_stats_reader` reads the page
+     * without taking any lock of the pools.
+     *
+     * The page holds up to 64 pools.
+     */
+    class shm_stats_page
+    {
+    public:
+        using layout_type = detail::shm_stats_layout;  ///< Layout of the page.
+
+        /**
+         * @brief      Returns the name of the default page of process `pid`,
+         * which appears as `/dev/shm/object_pool.<pid>`.
+         */
+        static std::string default_name(pid_t pid = ::getpid())
+        {
+            return "/object_pool." + std::to_string(pid);
+        }
+
+        /**
+         * @brief      Creates the page, replacing a stale page of the same
+         * name.
+         *
+         * @param[in]  name  Name of the page, as given to `shm_open()`.
+         *
+         * @throws     std::system_error if the page cannot be created.
+         */
+        explicit
+        shm_stats_page(const std::string& name = default_name())
+            :   m_name(name)
+        {
+            int fd = ::shm_open(m_name.c_str(), O_CREAT | O_RDWR, 0644);
+            if (fd == -1)
+                throw std::system_error(errno, std::generic_category(), "shm_open");
+
+            void* addr = MAP_FAILED;
+            if (::ftruncate(fd, 0) == 0 && ::ftruncate(fd, sizeof(layout_type)) == 0)
+                addr = ::mmap(nullptr, sizeof(layout_type), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            int error = errno;
+            ::close(fd);
+
+            if (addr == MAP_FAILED)
+            {
+                ::shm_unlink(m_name.c_str());
+                throw std::system_error(error, std::generic_category(), "mmap");
+            }
+
+            m_layout = ::new (addr) layout_type();
+            m_layout->magic.store(layout_type::magic_value, std::memory_order_release);
+        }
+
+        shm_stats_page(const shm_stats_page&) = delete;
+        shm_stats_page& operator=(const shm_stats_page&) = delete;
+
+        /**
+         * @brief      Detaches every pool and removes the page.
+         */
+        ~shm_stats_page()
+        {
+            for (std::pair<const std::string, attachment>& entry : m_attached)
+                entry.second.detach();
+            m_layout->~layout_type();
+            ::munmap(m_layout, sizeof(layout_type));
+            ::shm_unlink(m_name.c_str());
+        }
+
+        /**
+         * @brief      Returns the name of the page.
+         */
+        const std::string& name() const
+        {
+            return m_name;
+        }
+
+        /**
+         * @brief      Publishes the counters of `pool` under `name`,
+         * replacing any pool of the same name.
+         *
+         * @param[in]  name  Name of the pool. Truncated to 47 characters.
+         * @param[in]  pool  The pool. The page shares it until it is
+         * detached.
+         *
+         * @throws     std::length_error if the page is full.
+         */
+        template <class _Tp, class _Allocator, class _Mutex>
+        void attach(const std::string& name, const object_pool<_Tp, _Allocator, _Mutex>& pool)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            this->detach_locked(name);
+
+            std::size_t index = 0;
+            while (index < layout_type::entry_count && (m_layout->entries[index].state.load(std::memory_order_relaxed) & 1))
+                ++index;
+            if (index == layout_type::entry_count)
+                throw std::length_error("shm_stats_page is full");
+
+            detail::shm_stats_entry& entry = m_layout->entries[index];
+            std::memset(entry.name, 0, entry.name_size);
+            name.copy(entry.name, entry.name_size - 1);
+            entry.stats.clear();
+
+            object_pool<_Tp, _Allocator, _Mutex> shared(pool);
+            shared.set_stats_slot(&entry.stats);
+            entry.state.store(entry.state.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+
+            attachment att;
+            att.index = index;
+            att.detach = [shared] (void) mutable { shared.set_stats_slot(nullptr); };
+            m_attached[name] = std::move(att);
+        }
+
+        /**
+         * @brief      Stops publishing the pool attached under `name`, if any.
+         *
+         * @param[in]  name  Name of the pool.
+         */
+        void detach(const std::string& name)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            this->detach_locked(name);
+        }
+
+    private:
+        /**
+         * A pool attached to the page.
+         */
+        struct attachment
+        {
+            std::size_t             index;      ///< Entry of the pool.
+            std::function<void()>   detach;     ///< Stops the pool writing to the entry.
+        };
+
+        void detach_locked(const std::string& name)
+        {
+            std::map<std::string, attachment>::iterator it = m_attached.find(name);
+            if (it == m_attached.end())
+                return;
+
+            // once detached, the pool no longer writes to the entry
+            it->second.detach();
+            std::atomic<std::uint32_t>& state = m_layout->entries[it->second.index].state;
+            state.store(state.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+            m_attached.erase(it);
+        }
+
+        std::string                         m_name;     ///< Name of the page.
+        layout_type*                        m_layout;   ///< The mapped page.
+        std::mutex                          m_mutex;    ///< Guards the attachments.
+        std::map<std::string, attachment>   m_attached; ///< Attached pools, by name.
+    };
+
+    /**
+     * @brief      Reads the counters published to a `shm_stats_page`,
+     * usually by another process.
+     *
+     * Reading never blocks the publishing pools. A pool whose counters are
+     * being written is retried a few times, then skipped until the next
+     * read.
+     */
+    class shm_stats_reader
+    {
+    public:
+        using layout_type = detail::shm_stats_layout;  ///< Layout of the page.
+
+        /**
+         * @brief      Maps the page read-only.
+         *
+         * @param[in]  name  Name of the page, e.g.
+         * `shm_stats_page::default_name(pid)`.
+         *
+         * @throws     std::system_error if the page cannot be opened.
+         * @throws     std::runtime_error if the page is not a stats page.
+         */
+        explicit
+        shm_stats_reader(const std::string& name)
+        {
+            int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+            if (fd == -1)
+                throw std::system_error(errno, std::generic_category(), "shm_open");
+
+            struct stat st;
+            if (::fstat(fd, &st) == -1 || static_cast<std::size_t>(st.st_size) < sizeof(layout_type))
+            {
+                ::close(fd);
+                throw std::runtime_error("shm_stats_reader: " + name + " is not a stats page");
+            }
+
+            void* addr = ::mmap(nullptr, sizeof(layout_type), PROT_READ, MAP_SHARED, fd, 0);
+            int error = errno;
+            ::close(fd);
+            if (addr == MAP_FAILED)
+                throw std::system_error(error, std::generic_category(), "mmap");
+
+            m_layout = static_cast<const layout_type*>(addr);
+            if (m_layout->magic.load(std::memory_order_acquire) != layout_type::magic_value ||
+                m_layout->version != layout_type::version_value)
+            {
+                ::munmap(addr, sizeof(layout_type));
+                throw std::runtime_error("shm_stats_reader: " + name + " is not a stats page");
+            }
+        }
+
+        shm_stats_reader(const shm_stats_reader&) = delete;
+        shm_stats_reader& operator=(const shm_stats_reader&) = delete;
+
+        ~shm_stats_reader()
+        {
+            ::munmap(const_cast<layout_type*>(m_layout), sizeof(layout_type));
+        }
+
+        /**
+         * @brief      Returns the counters of every pool published to the
+         * page, in the order of their entries.
+         */
+        named_metrics read() const
+        {
+            named_metrics pools;
+            for (const detail::shm_stats_entry& entry : m_layout->entries)
+            {
+                std::uint32_t state = entry.state.load(std::memory_order_acquire);
+                if (!(state & 1))
+                    continue;
+
+                char name[detail::shm_stats_entry::name_size];
+                std::memcpy(name, entry.name, sizeof(name));
+                name[sizeof(name) - 1] = '\0';
+
+                pool_metrics m;
+                bool loaded = false;
+                for (int attempt = 0; attempt < 64 && !loaded; ++attempt)
+                    loaded = entry.stats.try_load(m);
+
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (loaded && entry.state.load(std::memory_order_relaxed) == state)
+                    pools.emplace_back(name, m);
+            }
+            return pools;
+        }
+
+    private:
+        const layout_type*  m_layout;   ///< The mapped page.
+    };
+}
+
+#endif
@@ -0,0 +1,367 @@
+/*
+ *  Copyright 2017 Carlos David Brito Pacheco
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ * 
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ * 
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef CARLOSB_SLOT_MAP_HPP
+#define CARLOSB_SLOT_MAP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace carlosb
+{
+    /**
+     * @brief      Container of values addressed by stable keys and stored
+     * contiguously.
+     *
+     * Inserting a value returns a key which keeps referring to it until it is
+     * erased, no matter how many other values are inserted or erased. Keys
+     * carry a generation, so a key to an erased value never refers to a
+     * value inserted afterwards in the same slot. Values are kept densely
+     * packed, in no particular order, for fast iteration: erasing a value
+     * moves the last value into its place.
+     *
+     * Unlike `object_pool`, a `slot_map` is not synchronized. Pointers and
+     * references to values are invalidated by insertions and erasures; keys
+     * are not.
+     *
+     * @tparam     T          Type of the values.
+     * @tparam     Allocator  Allocator of the values.
+     */
+    template <
+        class _Tp,
+        class _Allocator = std::allocator<_Tp>
+    >
+    class slot_map
+    {
+    public:
+        using value_type        = _Tp;                                  ///< Type of the values.
+        using reference         = _Tp&;                                 ///< l-value reference.
+        using const_reference   = const _Tp&;                           ///< const l-value reference.
+        using size_type         = std::size_t;                          ///< Size type used.
+        using allocator_type    = _Allocator;                           ///< Type of allocator.
+        using container_type    = std::vector<_Tp, _Allocator>;         ///< Dense storage of the values.
+        using iterator          = typename container_type::iterator;            ///< Iterates over the values.
+        using const_iterator    = typename container_type::const_iterator;      ///< Iterates over the values.
+
+        /**
+         * @brief      Stable reference to a value of the map.
+         */
+        struct key_type
+        {
+            std::uint32_t   index;          ///< Slot of the value.
+            std::uint32_t   generation;     ///< Generation of the slot when the value was inserted.
+
+            bool operator==(const key_type& other) const
+            {
+                return index == other.index && generation == other.generation;
+            }
+
+            bool operator!=(const key_type& other) const
+            {
+                return !(*this == other);
+            }
+        };
+
+        /**
+         * @brief      Constructs an empty map.
+         *
+         * @param[in]  alloc  The allocator.
+         */
+        explicit
+        slot_map(const _Allocator& alloc = _Allocator())
+            :   m_values(alloc),
+                m_free_head(npos)
+        {}
+
+        /**
+         * @brief      Inserts a copy of `value`.
+         *
+         * @param[in]  value  The value.
+         *
+         * @return     Key of the value.
+         *
+         * Complexity
+         * ----------
+         * Amortized constant.
+         */
+        key_type insert(const_reference value)
+        {
+            return this->emplace(value);
+        }
+
+        /**
+         * @brief      Inserts `value` by moving it.
+         *
+         * @param[in]  value  The value.
+         *
+         * @return     Key of the value.
+         */
+        key_type insert(_Tp&& value)
+        {
+            return this->emplace(std::move(value));
+        }
+
+        /**
+         * @brief      Inserts a value constructed from `args`.
+         *
+         * @param[in]  args  Arguments forwarded to the constructor.
+         *
+         * @return     Key of the value.
+         *
+         * Complexity
+         * ----------
+         * Amortized constant.
+         */
+        template <class... Args>
+        key_type emplace(Args&&... args)
+        {
+            if (m_free_head == npos && m_slots.size() >= npos)
+                throw std::length_error("slot_map::emplace(): Too many slots.");
+
+            m_erase.reserve(m_values.size() + 1);
+            if (m_free_head == npos)
+                m_slots.reserve(m_slots.size() + 1);
+            m_values.emplace_back(std::forward<Args>(args)...);
+
+            // nothing below throws
+            std::uint32_t index;
+            if (m_free_head != npos)
+            {
+                index = m_free_head;
+                m_free_head = m_slots[index].position;
+            }
+            else
+            {
+                index = static_cast<std::uint32_t>(m_slots.size());
+                m_slots.push_back(slot{0, 0});
+            }
+            m_erase.push_back(index);
+
+            slot& s = m_slots[index];
+            s.position = static_cast<std::uint32_t>(m_values.size() - 1);
+            return key_type{index, s.generation};
+        }
+
+        /**
+         * @brief      Erases the value referred to by `key`.
+         *
+         * @param[in]  key   Key of the value.
+         *
+         * @return     Whether a value was erased. Nothing is erased if the
+         * key is stale.
+         *
+         * Complexity
+         * ----------
+         * Constant.
+         */
+        bool erase(key_type key)
+        {
+            if (!this->contains(key))
+                return false;
+
+            slot& s = m_slots[key.index];
+            std::uint32_t position = s.position;
+            std::uint32_t last = static_cast<std::uint32_t>(m_values.size() - 1);
+            if (position != last)
+            {
+                m_values[position] = std::move(m_values[last]);
+                m_erase[position] = m_erase[last];
+                m_slots[m_erase[position]].position = position;
+            }
+            m_values.pop_back();
+            m_erase.pop_back();
+
+            ++s.generation;
+            s.position = m_free_head;
+            m_free_head = key.index;
+            return true;
+        }
+
+        /**
+         * @brief      Returns the value referred to by `key`.
+         *
+         * @param[in]  key   Key of the value.
+         *
+         * @return     Pointer to the value, or `nullptr` if the key is stale.
+         *
+         * Complexity
+         * ----------
+         * Constant.
+         */
+        _Tp* find(key_type key)
+        {
+            return this->contains(key) ? &m_values[m_slots[key.index].position] : nullptr;
+        }
+
+        /**
+         * @brief      Returns the value referred to by `key`.
+         *
+         * @param[in]  key   Key of the value.
+         *
+         * @return     Pointer to the value, or `nullptr` if the key is stale.
+         */
+        const _Tp* find(key_type key) const
+        {
+            return this->contains(key) ? &m_values[m_slots[key.index].position] : nullptr;
+        }
+
+        /**
+         * @brief      Returns the value referred to by `key`.
+         *
+         * @param[in]  key   Key of the value.
+         *
+         * @return     Reference to the value.
+         *
+         * @throws     std::out_of_range if the key is stale.
+         */
+        reference at(key_type key)
+        {
+            if (!this->contains(key))
+                throw std::out_of_range("slot_map::at(): Stale key.");
+            return m_values[m_slots[key.index].position];
+        }
+
+        /**
+         * @brief      Returns the value referred to by `key`.
+         *
+         * @param[in]  key   Key of the value.
+         *
+         * @return     Reference to the value.
+         *
+         * @throws     std::out_of_range if the key is stale.
+         */
+        const_reference at(key_type key) const
+        {
+            if (!this->contains(key))
+                throw std::out_of_range("slot_map::at(): Stale key.");
+            return m_values[m_slots[key.index].position];
+        }
+
+        /**
+         * @brief      Checks if `key` refers to a value of the map.
+         *
+         * @param[in]  key   The key.
+         */
+        bool contains(key_type key) const
+        {
+            return key.index < m_slots.size() && m_slots[key.index].generation == key.generation
+                && m_slots[key.index].position < m_values.size() && m_erase[m_slots[key.index].position] == key.index;
+        }
+
+        /**
+         * @brief      Erases every value. Keys to them become stale.
+         */
+        void clear()
+        {
+            while (!m_erase.empty())
+                this->erase(key_type{m_erase.back(), m_slots[m_erase.back()].generation});
+        }
+
+        /**
+         * @brief      Reserves storage for `new_cap` values.
+         *
+         * @param[in]  new_cap  The new capacity.
+         */
+        void reserve(size_type new_cap)
+        {
+            m_values.reserve(new_cap);
+            m_erase.reserve(new_cap);
+            m_slots.reserve(new_cap);
+        }
+
+        /**
+         * @brief      Returns the number of values.
+         */
+        size_type size() const
+        {
+            return m_values.size();
+        }
+
+        /**
+         * @brief      Checks if the map has no values.
+         */
+        bool empty() const
+        {
+            return m_values.empty();
+        }
+
+        /**
+         * @brief      Returns the number of values the map can hold without
+         * reallocating.
+         */
+        size_type capacity() const
+        {
+            return m_values.capacity();
+        }
+
+        /**
+         * @brief      Returns the key of the value at `pos` of the dense
+         * storage.
+         *
+         * @param[in]  pos   Position of the value, e.g. `it - begin()`.
+         */
+        key_type key_of(size_type pos) const
+        {
+            return key_type{m_erase[pos], m_slots[m_erase[pos]].generation};
+        }
+
+        iterator begin()                { return m_values.begin(); }    ///< Iterator to the first value.
+        iterator end()                  { return m_values.end(); }      ///< Iterator past the last value.
+        const_iterator begin() const    { return m_values.begin(); }    ///< Iterator to the first value.
+        const_iterator end() const      { return m_values.end(); }      ///< Iterator past the last value.
+
+    private:
+        static constexpr std::uint32_t npos = static_cast<std::uint32_t>(-1);
+
+        /**
+         * Position of the value of an occupied slot, or the next free slot
+         * of a free one (npos if it is the last), and the generation of the
+         * slot.
+         */
+        struct slot
+        {
+            std::uint32_t   position;
+            std::uint32_t   generation;
+        };
+
+        container_type              m_values;               ///< Densely packed values.
+        std::vector<std::uint32_t>  m_erase;                ///< Slot of each value.
+        std::vector<slot>           m_slots;                ///< Indirection from keys to values.
+        std::uint32_t               m_free_head;            ///< First free slot, npos if none.
+    };
+
+    template <class _Tp, class _Allocator>
+    constexpr std::uint32_t slot_map<_Tp, _Allocator>::npos;
+}
+
+#endif
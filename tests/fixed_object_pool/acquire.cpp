@@ -0,0 +1,127 @@
+#include "catch.hpp"
+#include "fixed_object_pool.hpp"
+
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+struct alignas(128) fixed_over_aligned
+{
+    int value;
+};
+
+SCENARIO( "objects can be acquired from a fixed pool", "[fixed_object_pool]" )
+{
+    GIVEN( "A fixed pool of 3 strings" )
+    {
+        carlosb::fixed_object_pool<string> pool(3, "Hello World!");
+
+        REQUIRE(pool.capacity() == 3);
+        REQUIRE(pool.size() == 3);
+        REQUIRE(! pool.in_use());
+
+        THEN ("We can acquire every object and no more.")
+        {
+            auto obj1 = pool.acquire();
+            auto obj2 = pool.acquire();
+            auto obj3 = pool.acquire();
+            auto obj4 = pool.acquire();
+
+            REQUIRE(*obj1 == "Hello World!");
+            REQUIRE(static_cast<bool>(obj2));
+            REQUIRE(static_cast<bool>(obj3));
+            REQUIRE(! static_cast<bool>(obj4));
+            REQUIRE(pool.empty());
+            REQUIRE(pool.in_use());
+        }
+
+        THEN ("Objects are recycled in FIFO order.")
+        {
+            string* first = nullptr;
+            {
+                auto obj = pool.acquire();
+                first = &*obj;
+            }
+            auto obj1 = pool.acquire();
+            auto obj2 = pool.acquire();
+            auto obj3 = pool.acquire();
+
+            REQUIRE(&*obj1 != first);
+            REQUIRE(&*obj2 != first);
+            REQUIRE(&*obj3 == first);
+        }
+
+        THEN ("Copies of the pool share its objects.")
+        {
+            carlosb::fixed_object_pool<string> copy = pool;
+            {
+                auto obj = pool.acquire();
+                pool = carlosb::fixed_object_pool<string>(1);
+                REQUIRE(*obj == "Hello World!");
+                REQUIRE(copy.size() == 2);
+            }
+            REQUIRE(copy.size() == 3);
+            REQUIRE(! copy.in_use());
+        }
+
+        THEN ("Threads can share the pool.")
+        {
+            vector<thread> threads;
+            for (int t = 0; t < 4; ++t)
+            {
+                threads.emplace_back([&pool]()
+                {
+                    for (int i = 0; i < 10000; ++i)
+                    {
+                        if (auto obj = pool.acquire())
+                            obj->push_back('!');
+                    }
+                });
+            }
+            for (auto& t : threads)
+                t.join();
+
+            REQUIRE(pool.size() == 3);
+            REQUIRE(! pool.in_use());
+        }
+    }
+}
+
+SCENARIO( "objects of a fixed pool are aligned", "[fixed_object_pool]" )
+{
+    GIVEN( "A fixed pool of over-aligned objects" )
+    {
+        carlosb::fixed_object_pool<fixed_over_aligned> pool(5);
+
+        THEN ("Every object honours the alignment of its type.")
+        {
+            vector<carlosb::fixed_object_pool<fixed_over_aligned>::acquired_type> objects;
+            while (auto obj = pool.acquire())
+            {
+                REQUIRE(reinterpret_cast<uintptr_t>(&*obj) % alignof(fixed_over_aligned) == 0);
+                objects.push_back(std::move(obj));
+            }
+            REQUIRE(objects.size() == 5);
+        }
+    }
+
+    GIVEN( "A fixed pool of ints using a cache aligned allocator" )
+    {
+        carlosb::fixed_object_pool<int, carlosb::cache_aligned_allocator<int>> pool(4, 7);
+
+        THEN ("Every object lives in its own cache line.")
+        {
+            vector<carlosb::fixed_object_pool<int, carlosb::cache_aligned_allocator<int>>::acquired_type> objects;
+            while (auto obj = pool.acquire())
+            {
+                REQUIRE(*obj == 7);
+                REQUIRE(reinterpret_cast<uintptr_t>(&*obj) % carlosb::cache_line_size == 0);
+                objects.push_back(std::move(obj));
+            }
+            REQUIRE(objects.size() == 4);
+        }
+    }
+}
@@ -0,0 +1,126 @@
+#include "catch.hpp"
+#include "io_buffer_pool.hpp"
+
+#include <cstdint>
+#include <set>
+
+using namespace std;
+
+SCENARIO( "page-aligned buffers can be acquired from an io_buffer_pool", "[io_buffer_pool]" )
+{
+    GIVEN( "A pool of 4 buffers of 1000 bytes" )
+    {
+        carlosb::io_buffer_pool pool(4, 1000);
+
+        THEN ("Buffers are page-aligned pages of one region.")
+        {
+            REQUIRE(pool.buffer_size() == carlosb::io_page_size);
+            REQUIRE(pool.capacity() == 4);
+            REQUIRE(pool.iovecs().size() == 4);
+
+            unsigned char* base = static_cast<unsigned char*>(pool.iovecs()[0].iov_base);
+            REQUIRE(reinterpret_cast<uintptr_t>(base) % carlosb::io_page_size == 0);
+            for (size_t i = 0; i < 4; ++i)
+            {
+                REQUIRE(pool.iovecs()[i].iov_base == base + i * pool.buffer_size());
+                REQUIRE(pool.iovecs()[i].iov_len == pool.buffer_size());
+            }
+        }
+
+        THEN ("Leases carry the index of their buffer.")
+        {
+            set<unsigned> indices;
+            auto buf1 = pool.acquire();
+            auto buf2 = pool.acquire();
+            auto buf3 = pool.acquire();
+            auto buf4 = pool.acquire();
+            for (auto* buf : {&buf1, &buf2, &buf3, &buf4})
+            {
+                REQUIRE(static_cast<bool>(*buf));
+                REQUIRE((*buf)->data() == pool.iovecs()[(*buf)->index()].iov_base);
+                indices.insert((*buf)->index());
+            }
+            REQUIRE(indices.size() == 4);
+            REQUIRE(! static_cast<bool>(pool.acquire()));
+        }
+
+        THEN ("Parked leases return to the pool on completion.")
+        {
+            auto token = pool.park(pool.acquire());
+            REQUIRE(pool.size() == 3);
+
+            pool.complete(token);
+            REQUIRE(pool.size() == 4);
+        }
+
+        THEN ("Leases of another pool cannot be parked.")
+        {
+            carlosb::io_buffer_pool other(8, 1000);
+            auto buf1 = other.acquire();
+            auto buf2 = other.acquire();
+            auto buf3 = other.acquire();
+            auto buf4 = other.acquire();
+            auto buf5 = other.acquire();
+
+            REQUIRE_THROWS_AS(pool.park(std::move(buf1)), std::invalid_argument);
+            REQUIRE_THROWS_AS(pool.park(std::move(buf5)), std::invalid_argument);
+            REQUIRE(pool.size() == 4);
+        }
+
+        THEN ("Buffers outlive the pool while acquired.")
+        {
+            carlosb::io_buffer_pool::acquired_type buf;
+            {
+                carlosb::io_buffer_pool other(1, 1);
+                buf = other.acquire();
+            }
+            buf->data()[0] = 42;
+            REQUIRE(buf->data()[0] == 42);
+        }
+    }
+}
+
+SCENARIO( "chains of buffers can be acquired for vectored I/O", "[io_buffer_pool]" )
+{
+    GIVEN( "A pool of 4 buffers of one page" )
+    {
+        carlosb::io_buffer_pool pool(4, carlosb::io_page_size);
+        const size_t page = carlosb::io_page_size;
+
+        THEN ("A chain spans as many buffers as the message needs.")
+        {
+            auto chain = pool.acquire_chain(2 * page + 10);
+            REQUIRE(static_cast<bool>(chain));
+            REQUIRE(chain.iovcnt() == 3);
+            REQUIRE(chain.size() == 2 * page + 10);
+            REQUIRE(chain.iov()[0].iov_len == page);
+            REQUIRE(chain.iov()[1].iov_len == page);
+            REQUIRE(chain.iov()[2].iov_len == 10);
+            REQUIRE(chain.iov()[2].iov_base == chain[2]->data());
+            REQUIRE(pool.size() == 1);
+        }
+
+        THEN ("The whole chain is released at once.")
+        {
+            {
+                auto chain = pool.acquire_chain(4 * page);
+                REQUIRE(chain.iovcnt() == 4);
+                REQUIRE(pool.size() == 0);
+            }
+            REQUIRE(pool.size() == 4);
+
+            auto chain = pool.acquire_chain(page);
+            chain = carlosb::none;
+            REQUIRE(pool.size() == 4);
+        }
+
+        THEN ("No buffer is taken when there are not enough.")
+        {
+            auto buf = pool.acquire();
+            auto chain = pool.acquire_chain(4 * page);
+            REQUIRE(! static_cast<bool>(chain));
+            REQUIRE(pool.size() == 3);
+            REQUIRE(! static_cast<bool>(pool.acquire_chain(0)));
+        }
+    }
+}
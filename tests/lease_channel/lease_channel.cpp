@@ -0,0 +1,126 @@
+#include "catch.hpp"
+#include "lease_channel.hpp"
+
+#include <string>
+#include <thread>
+#include <chrono>
+
+using namespace std;
+
+SCENARIO( "acquired objects can be moved between threads through a channel", "[lease_channel]" )
+{
+    GIVEN( "A pool of 4 strings and a channel of its objects" )
+    {
+        using pool_type = carlosb::object_pool<string>;
+        pool_type pool(4, "Hello World!");
+        carlosb::lease_channel<pool_type::acquired_type> channel(2);
+
+        THEN ("Leases keep their object while in the channel.")
+        {
+            REQUIRE(channel.try_send(pool.acquire()));
+            REQUIRE(pool.size() == 3);
+
+            pool_type::acquired_type obj;
+            REQUIRE(channel.try_receive(obj));
+            REQUIRE(*obj == "Hello World!");
+            REQUIRE(pool.size() == 3);
+
+            obj = carlosb::none;
+            REQUIRE(pool.size() == 4);
+        }
+
+        THEN ("A lease which could not be sent is kept by the sender.")
+        {
+            REQUIRE(channel.try_send(pool.acquire()));
+            REQUIRE(channel.try_send(pool.acquire()));
+
+            auto obj = pool.acquire();
+            REQUIRE(! channel.try_send(std::move(obj)));
+            REQUIRE(static_cast<bool>(obj));
+        }
+
+        THEN ("Leases left in the channel return to the pool with it.")
+        {
+            {
+                carlosb::lease_channel<pool_type::acquired_type> other(2);
+                other.send(pool.acquire());
+                REQUIRE(pool.size() == 3);
+            }
+            REQUIRE(pool.size() == 4);
+        }
+
+        THEN ("A closed channel refuses leases and keeps them with the sender.")
+        {
+            channel.close();
+
+            auto obj = pool.acquire();
+            REQUIRE(! channel.send(std::move(obj)));
+            REQUIRE(! channel.try_send(std::move(obj)));
+            REQUIRE(static_cast<bool>(obj));
+            REQUIRE(! channel.receive());
+        }
+
+        THEN ("A sleeping receiver is woken by a send and by closing.")
+        {
+            pool_type::acquired_type first, second;
+            thread consumer([&channel, &first, &second]()
+            {
+                first = channel.receive();
+                second = channel.receive();
+            });
+
+            this_thread::sleep_for(chrono::milliseconds(50));
+            REQUIRE(channel.send(pool.acquire()));
+            this_thread::sleep_for(chrono::milliseconds(50));
+            channel.close();
+            consumer.join();
+
+            REQUIRE(static_cast<bool>(first));
+            REQUIRE(! second);
+        }
+
+        THEN ("A sleeping sender is woken when there is room.")
+        {
+            REQUIRE(channel.send(pool.acquire()));
+            REQUIRE(channel.send(pool.acquire()));
+
+            thread producer([&pool, &channel]()
+            {
+                channel.send(pool.acquire());
+            });
+
+            this_thread::sleep_for(chrono::milliseconds(50));
+            REQUIRE(static_cast<bool>(channel.receive()));
+            producer.join();
+            REQUIRE(channel.size_approx() == 2);
+        }
+
+        THEN ("A pipeline stage receives every object sent by another.")
+        {
+            const int messages = 10000;
+            thread producer([&pool, &channel, messages]()
+            {
+                for (int i = 0; i < messages; ++i)
+                {
+                    auto obj = pool.acquire_wait();
+                    *obj = to_string(i);
+                    channel.send(std::move(obj));
+                }
+                channel.close();
+            });
+
+            int received = 0;
+            bool ordered = true;
+            while (auto obj = channel.receive())
+            {
+                ordered = ordered && *obj == to_string(received);
+                ++received;
+            }
+            producer.join();
+
+            REQUIRE(received == messages);
+            REQUIRE(ordered);
+            REQUIRE(pool.size() == 4);
+        }
+    }
+}
@@ -0,0 +1,79 @@
+#include "catch.hpp"
+#include "mpmc_ring.hpp"
+
+#include <thread>
+#include <vector>
+#include <atomic>
+
+using namespace std;
+
+SCENARIO( "a ring passes elements between threads", "[mpmc_ring]" )
+{
+    GIVEN( "A ring of 5 ints" )
+    {
+        carlosb::mpmc_ring<int> ring(5);
+
+        THEN ("The capacity is rounded up to a power of two.")
+        {
+            REQUIRE(ring.capacity() == 8);
+        }
+
+        THEN ("Elements are popped in the order they were pushed.")
+        {
+            for (int i = 0; i < 8; ++i)
+                REQUIRE(ring.try_push(i));
+            REQUIRE(! ring.try_push(8));
+            REQUIRE(ring.size_approx() == 8);
+
+            int value;
+            for (int i = 0; i < 8; ++i)
+            {
+                REQUIRE(ring.try_pop(value));
+                REQUIRE(value == i);
+            }
+            REQUIRE(! ring.try_pop(value));
+        }
+
+        THEN ("Every element is popped exactly once by concurrent consumers.")
+        {
+            const int producers = 4, per_producer = 10000;
+            atomic<long> sum(0);
+            atomic<int> popped(0);
+
+            vector<thread> threads;
+            for (int p = 0; p < producers; ++p)
+            {
+                threads.emplace_back([&ring, p, per_producer]()
+                {
+                    for (int i = 1; i <= per_producer; ++i)
+                    {
+                        while (!ring.try_push(i))
+                            this_thread::yield();
+                    }
+                    (void) p;
+                });
+                threads.emplace_back([&ring, &sum, &popped, producers, per_producer]()
+                {
+                    int value;
+                    while (popped.load() < producers * per_producer)
+                    {
+                        if (ring.try_pop(value))
+                        {
+                            sum += value;
+                            ++popped;
+                        }
+                        else
+                        {
+                            this_thread::yield();
+                        }
+                    }
+                });
+            }
+            for (auto& t : threads)
+                t.join();
+
+            REQUIRE(popped.load() == producers * per_producer);
+            REQUIRE(sum.load() == static_cast<long>(producers) * per_producer * (per_producer + 1) / 2);
+        }
+    }
+}
@@ -0,0 +1,143 @@
+#include "catch.hpp"
+#include "object_pool.hpp"
+
+#include <cstdlib>
+#include <new>
+#include <string>
+
+using namespace std;
+
+// counts the allocations of the calling thread while enabled
+static thread_local bool count_allocations = false;
+static thread_local size_t allocations = 0;
+
+void* operator new(size_t size)
+{
+    if (count_allocations)
+        ++allocations;
+    if (void* ptr = malloc(size > 0 ? size : 1))
+        return ptr;
+    throw bad_alloc();
+}
+
+void* operator new(size_t size, const nothrow_t&) noexcept
+{
+    if (count_allocations)
+        ++allocations;
+    return malloc(size > 0 ? size : 1);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void* ptr, const nothrow_t&) noexcept
+{
+    free(ptr);
+}
+
+SCENARIO( "objects can be reused under a key", "[object_pool]" )
+{
+    GIVEN( "A pool of 3 strings" )
+    {
+        carlosb::object_pool<string> pool(3, "Hello World!");
+
+        THEN ("The object released under a key is acquired again under it.")
+        {
+            string* warm = nullptr;
+            {
+                auto obj = pool.acquire_affine(7);
+                REQUIRE(static_cast<bool>(obj));
+                *obj = "Session 7";
+                warm = &*obj;
+            }
+
+            // plain acquisitions leave the parked object alone
+            auto obj1 = pool.acquire();
+            auto obj2 = pool.acquire();
+            REQUIRE(&*obj1 != warm);
+            REQUIRE(&*obj2 != warm);
+            obj1 = carlosb::none;
+            obj2 = carlosb::none;
+
+            auto obj3 = pool.acquire_affine(7);
+            REQUIRE(&*obj3 == warm);
+            REQUIRE(*obj3 == "Session 7");
+        }
+
+        THEN ("Parked objects count as free objects.")
+        {
+            {
+                auto obj = pool.acquire_affine(7);
+            }
+            REQUIRE(pool.size() == 3);
+            REQUIRE(! pool.in_use());
+
+            auto obj1 = pool.acquire();
+            auto obj2 = pool.acquire();
+            auto obj3 = pool.acquire();
+            REQUIRE(static_cast<bool>(obj3));
+            REQUIRE(pool.empty());
+        }
+
+        THEN ("Another object is acquired when the preferred one is busy.")
+        {
+            string* warm = nullptr;
+            {
+                auto obj = pool.acquire_affine(7);
+                warm = &*obj;
+            }
+            auto obj1 = pool.acquire_affine(7);
+            auto obj2 = pool.acquire_affine(7);
+
+            REQUIRE(&*obj1 == warm);
+            REQUIRE(static_cast<bool>(obj2));
+            REQUIRE(&*obj2 != warm);
+        }
+
+        THEN ("Only the last object released under a key is parked.")
+        {
+            string* last = nullptr;
+            {
+                auto obj1 = pool.acquire_affine(7);
+                auto obj2 = pool.acquire_affine(7);
+                last = &*obj2;
+                obj1 = carlosb::none;
+            }
+            REQUIRE(pool.size() == 3);
+
+            auto obj3 = pool.acquire_affine(7);
+            REQUIRE(&*obj3 == last);
+        }
+    }
+
+    GIVEN( "A pool of 4 contexts used by 4 workers" )
+    {
+        carlosb::object_pool<string> pool(4, string(100, 'x'));
+
+        THEN ("Busy and idle cycles do not allocate once warm.")
+        {
+            for (int worker = 0; worker < 4; ++worker)
+                pool.acquire_affine_wait(worker);
+
+            count_allocations = true;
+            allocations = 0;
+            for (int cycle = 0; cycle < 100; ++cycle)
+            {
+                // busy: every worker holds its context
+                auto ctx0 = pool.acquire_affine_wait(0);
+                auto ctx1 = pool.acquire_affine_wait(1);
+                auto ctx2 = pool.acquire_affine_wait(2);
+                auto ctx3 = pool.acquire_affine_wait(3);
+                ctx1 = carlosb::none;
+                ctx3 = carlosb::none;
+                // idle: the contexts go back, parked under their worker
+            }
+            count_allocations = false;
+
+            REQUIRE(allocations == 0);
+            REQUIRE(pool.size() == 4);
+        }
+    }
+}
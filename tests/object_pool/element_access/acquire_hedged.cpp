@@ -0,0 +1,104 @@
+#include "catch.hpp"
+#include "object_pool.hpp"
+
+#include <string>
+#include <thread>
+#include <chrono>
+
+using namespace std;
+
+namespace
+{
+    // converts to a string slowly, to keep a construction in flight
+    struct slow_hello
+    {
+        operator string() const
+        {
+            this_thread::sleep_for(chrono::milliseconds(200));
+            return "Slow";
+        }
+    };
+}
+
+SCENARIO( "acquisitions can be hedged by constructing extra objects", "[object_pool]" )
+{
+    GIVEN( "A drained pool of 1 string" )
+    {
+        carlosb::object_pool<string> pool(1, "Hello World!");
+        auto obj1 = pool.acquire();
+        REQUIRE(pool.empty());
+
+        THEN ("An extra object is constructed once the wait budget runs out.")
+        {
+            auto obj2 = pool.acquire_hedged(chrono::milliseconds(10), 1, "Extra");
+            REQUIRE(static_cast<bool>(obj2));
+            REQUIRE(*obj2 == "Extra");
+            REQUIRE(pool.capacity() >= 2);
+        }
+
+        THEN ("No more than max_extra objects are constructed.")
+        {
+            auto obj2 = pool.acquire_hedged(chrono::milliseconds(10), 1, "Extra");
+            auto obj3 = pool.acquire_hedged(chrono::milliseconds(10), 1, "Extra");
+            REQUIRE(static_cast<bool>(obj2));
+            REQUIRE(! static_cast<bool>(obj3));
+        }
+
+        THEN ("Extra objects are destroyed when released.")
+        {
+            {
+                auto obj2 = pool.acquire_hedged(chrono::milliseconds(10), 1, "Extra");
+                REQUIRE(static_cast<bool>(obj2));
+            }
+            REQUIRE(pool.size() == 0);
+
+            obj1 = carlosb::none;
+            REQUIRE(pool.size() == 1);
+            REQUIRE(! pool.in_use());
+
+            auto obj3 = pool.acquire();
+            REQUIRE(*obj3 == "Hello World!");
+        }
+
+        THEN ("The extra objects are counted across calls.")
+        {
+            auto obj2 = pool.acquire_hedged(chrono::milliseconds(10), 2, "Extra");
+            auto obj3 = pool.acquire_hedged(chrono::milliseconds(10), 1, "Extra");
+            REQUIRE(static_cast<bool>(obj2));
+            REQUIRE(! static_cast<bool>(obj3));
+        }
+
+        THEN ("No extra object is constructed beyond the limit of concurrent constructions.")
+        {
+            pool.set_max_concurrent_creations(1);
+            thread t([&pool]()
+            {
+                auto obj = pool.allocate(slow_hello());
+            });
+            this_thread::sleep_for(chrono::milliseconds(50));
+
+            auto obj2 = pool.acquire_hedged(chrono::milliseconds(10), 1, "Extra");
+            t.join();
+            REQUIRE(! static_cast<bool>(obj2));
+
+            auto obj3 = pool.acquire_hedged(chrono::milliseconds(10), 1, "Extra");
+            REQUIRE(static_cast<bool>(obj3));
+        }
+
+        THEN ("An object released within the budget is acquired instead.")
+        {
+            thread t([&obj1]()
+            {
+                this_thread::sleep_for(chrono::milliseconds(50));
+                *obj1 = "Released";
+                obj1 = carlosb::none;
+            });
+
+            auto obj2 = pool.acquire_hedged(chrono::milliseconds(5000), 1, "Extra");
+            t.join();
+
+            REQUIRE(static_cast<bool>(obj2));
+            REQUIRE(*obj2 == "Released");
+        }
+    }
+}
@@ -0,0 +1,75 @@
+#include "catch.hpp"
+#include "object_pool.hpp"
+
+#include <string>
+
+using namespace std;
+
+SCENARIO( "free objects can be acquired by property", "[object_pool]" )
+{
+    GIVEN( "A pool of strings of different lengths" )
+    {
+        carlosb::object_pool<string> pool;
+        pool.push("a");
+        pool.push("bb");
+        pool.push("ccc");
+        pool.push("dd");
+
+        THEN ("The most recent free object satisfying the predicate is acquired.")
+        {
+            auto obj = pool.acquire_if([] (const string& s) { return s.size() == 2; });
+            REQUIRE(static_cast<bool>(obj));
+            REQUIRE(*obj == "dd");
+            REQUIRE(pool.size() == 3);
+
+            auto obj2 = pool.acquire();
+            REQUIRE(*obj2 == "ccc");
+        }
+
+        THEN ("Nothing is acquired if no free object satisfies the predicate.")
+        {
+            auto obj = pool.acquire_if([] (const string& s) { return s.empty(); });
+            REQUIRE(! static_cast<bool>(obj));
+            REQUIRE(pool.size() == 4);
+        }
+
+        THEN ("We can acquire by an index over the free objects.")
+        {
+            pool.set_index([] (const string& s) { return s.size(); });
+            REQUIRE(pool.size() == 4);
+
+            auto obj1 = pool.acquire_where(2);
+            auto obj2 = pool.acquire_where(2);
+            auto obj3 = pool.acquire_where(2);
+            REQUIRE(static_cast<bool>(obj1));
+            REQUIRE(static_cast<bool>(obj2));
+            REQUIRE(obj1->size() == 2);
+            REQUIRE(obj2->size() == 2);
+            REQUIRE(! static_cast<bool>(obj3));
+
+            // objects are indexed by their state when released
+            *obj1 = "eeeee";
+            obj1 = carlosb::none;
+            auto obj4 = pool.acquire_where(5);
+            REQUIRE(*obj4 == "eeeee");
+
+            pool.push("ffff");
+            auto obj5 = pool.acquire_where(4);
+            REQUIRE(*obj5 == "ffff");
+
+            auto obj6 = pool.acquire();
+            auto obj7 = pool.acquire_if([] (const string& s) { return s.size() == 1 || s.size() == 3; });
+            REQUIRE(static_cast<bool>(obj6));
+            REQUIRE(static_cast<bool>(obj7));
+            REQUIRE(pool.empty());
+        }
+
+        THEN ("Removing the index keeps every free object.")
+        {
+            pool.set_index([] (const string& s) { return s.size(); });
+            pool.set_index(nullptr);
+            REQUIRE(pool.size() == 4);
+            REQUIRE(! static_cast<bool>(pool.acquire_where(2)));
+        }
+    }
+}
@@ -0,0 +1,42 @@
+#include "catch.hpp"
+#include "object_pool.hpp"
+
+#include <string>
+
+using namespace std;
+
+SCENARIO( "several objects can be acquired at once", "[object_pool]" )
+{
+    GIVEN( "A pool of 3 strings" )
+    {
+        carlosb::object_pool<string> pool(3, "Hello World!");
+
+        THEN ("Every object requested is acquired.")
+        {
+            auto objects = pool.acquire_many(2);
+            REQUIRE(objects.size() == 2);
+            REQUIRE(*objects[0] == "Hello World!");
+            REQUIRE(*objects[1] == "Hello World!");
+            REQUIRE(pool.size() == 1);
+
+            objects.clear();
+            REQUIRE(pool.size() == 3);
+        }
+
+        THEN ("No object is acquired when there are not enough.")
+        {
+            auto obj = pool.acquire();
+            auto objects = pool.acquire_many(3);
+            REQUIRE(objects.empty());
+            REQUIRE(pool.size() == 2);
+            REQUIRE(pool.metrics().misses == 3);
+        }
+
+        THEN ("Objects guaranteed to a tenant are not acquired.")
+        {
+            pool.set_tenant_quota(carlosb::tenant_t(1), 2, 2);
+            REQUIRE(pool.acquire_many(2).empty());
+            REQUIRE(pool.acquire_many(1).size() == 1);
+        }
+    }
+}
@@ -0,0 +1,173 @@
+#include "catch.hpp"
+#include "object_pool.hpp"
+
+#include <string>
+#include <thread>
+#include <chrono>
+#include <type_traits>
+
+using namespace std;
+
+namespace
+{
+    const carlosb::tenant_t alice(1);
+    const carlosb::tenant_t bob(2);
+}
+
+// a count or a time limit is never taken for a tenant
+static_assert(!is_convertible<int, carlosb::tenant_t>::value, "tenants must be named explicitly");
+
+SCENARIO( "tenants can share a pool within quotas", "[object_pool]" )
+{
+    GIVEN( "A pool of 4 strings with a tenant limited to 2 objects" )
+    {
+        carlosb::object_pool<string> pool(4, "Hello World!");
+        pool.set_tenant_quota(alice, 2);
+
+        THEN ("The tenant cannot hold more than its quota.")
+        {
+            auto obj1 = pool.acquire(alice);
+            auto obj2 = pool.acquire(alice);
+            auto obj3 = pool.acquire(alice);
+
+            REQUIRE(static_cast<bool>(obj1));
+            REQUIRE(static_cast<bool>(obj2));
+            REQUIRE(! static_cast<bool>(obj3));
+            REQUIRE(pool.outstanding(alice) == 2);
+            REQUIRE(pool.size() == 2);
+
+            auto obj4 = pool.acquire(bob);
+            REQUIRE(static_cast<bool>(obj4));
+            REQUIRE(pool.outstanding(bob) == 0);  // tenants without a quota are not tracked
+        }
+
+        THEN ("Released objects count against the quota no more.")
+        {
+            auto obj1 = pool.acquire(alice);
+            {
+                auto obj2 = pool.acquire(alice);
+            }
+            REQUIRE(pool.outstanding(alice) == 1);
+
+            auto obj3 = pool.acquire(alice);
+            REQUIRE(static_cast<bool>(obj3));
+
+            obj1 = carlosb::none;
+            obj3 = carlosb::none;
+            REQUIRE(pool.outstanding(alice) == 0);
+            REQUIRE(pool.size() == 4);
+        }
+
+        THEN ("Moved objects are accounted to their tenant.")
+        {
+            auto obj1 = pool.acquire(alice);
+            auto obj2 = std::move(obj1);
+            REQUIRE(pool.outstanding(alice) == 1);
+
+            obj2 = carlosb::none;
+            REQUIRE(pool.outstanding(alice) == 0);
+        }
+
+        THEN ("A tenant waits for its own objects, not for free ones.")
+        {
+            auto obj1 = pool.acquire(alice);
+            auto obj2 = pool.acquire(alice);
+
+            auto obj3 = pool.acquire_wait(alice, chrono::milliseconds(10));
+            REQUIRE(! static_cast<bool>(obj3));
+
+            thread t([&obj1]()
+            {
+                this_thread::sleep_for(chrono::milliseconds(50));
+                obj1 = carlosb::none;
+            });
+
+            obj3 = pool.acquire_wait(alice);
+            t.join();
+            REQUIRE(static_cast<bool>(obj3));
+            REQUIRE(pool.outstanding(alice) == 2);
+        }
+    }
+
+    GIVEN( "A pool of 3 strings with a tenant guaranteed 2 objects" )
+    {
+        carlosb::object_pool<string> pool(3, "Hello World!");
+        pool.set_tenant_quota(alice, 3, 2);
+
+        THEN ("Other tenants cannot take the guaranteed objects.")
+        {
+            auto obj1 = pool.acquire();
+            auto obj2 = pool.acquire(bob);
+
+            REQUIRE(static_cast<bool>(obj1));
+            REQUIRE(! static_cast<bool>(obj2));
+
+            auto obj3 = pool.acquire(alice);
+            auto obj4 = pool.acquire(alice);
+            REQUIRE(static_cast<bool>(obj3));
+            REQUIRE(static_cast<bool>(obj4));
+        }
+
+        THEN ("The guarantee shrinks while the tenant holds objects.")
+        {
+            auto obj1 = pool.acquire(alice);
+            auto obj2 = pool.acquire();
+            auto obj3 = pool.acquire();
+
+            REQUIRE(static_cast<bool>(obj1));
+            REQUIRE(static_cast<bool>(obj2));
+            REQUIRE(! static_cast<bool>(obj3));
+
+            auto obj4 = pool.acquire(alice);
+            REQUIRE(static_cast<bool>(obj4));
+            REQUIRE(pool.empty());
+        }
+    }
+
+    GIVEN( "An empty pool with a tenant at its quota" )
+    {
+        carlosb::object_pool<string> pool(1, "Hello World!");
+        pool.set_tenant_quota(alice, 1);
+        auto held = pool.acquire(alice);
+        REQUIRE(pool.empty());
+
+        // a waiter which is not woken only gets the object when its wait times out
+        chrono::steady_clock::duration waited = chrono::steady_clock::duration::zero();
+        bool acquired = false;
+        auto wait_for_object = [&pool, &waited, &acquired]()
+        {
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            acquired = static_cast<bool>(pool.acquire_wait(chrono::milliseconds(2000)));
+            waited = chrono::steady_clock::now() - start;
+        };
+
+        THEN ("A pushed object wakes a waiter allowed to take it.")
+        {
+            thread capped([&pool]()
+            {
+                pool.acquire_wait(alice, chrono::milliseconds(300));
+            });
+            this_thread::sleep_for(chrono::milliseconds(50));
+
+            thread uncapped(wait_for_object);
+            this_thread::sleep_for(chrono::milliseconds(50));
+
+            pool.push("Pushed");
+            uncapped.join();
+            capped.join();
+            REQUIRE(acquired);
+            REQUIRE(waited < chrono::milliseconds(1000));
+        }
+
+        THEN ("Growing the pool wakes the waiters.")
+        {
+            thread waiter(wait_for_object);
+            this_thread::sleep_for(chrono::milliseconds(50));
+
+            pool.resize(1);
+            waiter.join();
+            REQUIRE(acquired);
+            REQUIRE(waited < chrono::milliseconds(1000));
+        }
+    }
+}
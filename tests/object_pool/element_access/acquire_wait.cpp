@@ -44,6 +44,25 @@ SCENARIO( "you can wait until there is an acquisition or a timeout", "[object_po
             t2.join();
         }
 
+        THEN ("We can wait with a timeout until acquisition.")
+        {
+            auto obj = pool.acquire();
+            REQUIRE(obj);
+
+            thread t1([&obj]()
+            {
+                this_thread::sleep_for(chrono::milliseconds(100));
+                *obj = "Modified from t1";
+                obj = carlosb::none;
+            });
+
+            auto obj2 = pool.acquire_wait(chrono::milliseconds(5000));
+            t1.join();
+
+            REQUIRE(obj2);
+            REQUIRE(*obj2 == "Modified from t1");
+        }
+
         THEN ("We can wait until timeout for acquisition.")
         {
 
@@ -68,12 +87,24 @@ SCENARIO( "you can wait until there is an acquisition or a timeout", "[object_po
                 // At this point t1 should have the object and will sleep for 3 secs
                 // before returning the object. However, we set a timeout of 1 second
                 // so this should trigger a timeout.
+                chrono::steady_clock::time_point start = chrono::steady_clock::now();
                 auto obj = pool.acquire_wait(chrono::milliseconds(1000));
                 REQUIRE(!obj);
+                REQUIRE(chrono::steady_clock::now() - start >= chrono::milliseconds(1000));
             });
 
             t1.join();
             t2.join();
         }
+
+        THEN ("A timed wait on an empty pool lasts until its time limit.")
+        {
+            auto obj = pool.acquire();
+
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            auto obj2 = pool.acquire_wait(chrono::milliseconds(100));
+            REQUIRE(!obj2);
+            REQUIRE(chrono::steady_clock::now() - start >= chrono::milliseconds(100));
+        }
     }
-}
\ No newline at end of file
+}
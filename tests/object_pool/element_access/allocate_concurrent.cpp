@@ -0,0 +1,77 @@
+#include "catch.hpp"
+#include "object_pool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+static atomic<int> constructing(0);
+static atomic<int> max_constructing(0);
+
+struct slow_object
+{
+    slow_object()
+    {
+        int now = ++constructing;
+        int seen = max_constructing;
+        while (now > seen && !max_constructing.compare_exchange_weak(seen, now))
+        {}
+        this_thread::sleep_for(chrono::milliseconds(50));
+        --constructing;
+    }
+};
+
+SCENARIO( "concurrent constructions by allocate can be limited", "[object_pool]" )
+{
+    constructing = 0;
+    max_constructing = 0;
+
+    GIVEN( "An empty pool allowing a single construction at a time" )
+    {
+        using pool_type = carlosb::object_pool<slow_object>;
+
+        pool_type pool(0);
+        pool.set_max_concurrent_creations(1);
+
+        THEN ("Threads hitting the empty pool construct one object at a time.")
+        {
+            atomic<int> acquired(0);
+            vector<thread> threads;
+            for (int i = 0; i < 4; ++i)
+                threads.emplace_back([&pool, &acquired]()
+                {
+                    if (auto obj = pool.allocate())
+                        ++acquired;
+                    this_thread::sleep_for(chrono::milliseconds(10));
+                });
+
+            for (auto& t : threads)
+                t.join();
+
+            REQUIRE(acquired == 4);
+            REQUIRE(max_constructing == 1);
+            REQUIRE(pool.size() >= 1);
+            REQUIRE(pool.size() <= 4);
+            REQUIRE(! pool.in_use());
+        }
+
+        THEN ("Objects are constructed without holding the pool lock.")
+        {
+            thread t([&pool]()
+            {
+                auto obj = pool.allocate();
+            });
+
+            this_thread::sleep_for(chrono::milliseconds(10));
+            auto start = chrono::steady_clock::now();
+            REQUIRE(pool.size() == 0);
+            REQUIRE(chrono::steady_clock::now() - start < chrono::milliseconds(30));
+
+            t.join();
+            REQUIRE(pool.size() == 1);
+        }
+    }
+}
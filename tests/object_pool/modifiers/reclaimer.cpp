@@ -0,0 +1,126 @@
+#include "catch.hpp"
+#include "object_pool.hpp"
+#include "background_reclaimer.hpp"
+
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+static atomic<int>          destroyed_count(0);
+static atomic<int>          destroyed_elsewhere(0);
+static thread::id           owner_thread;
+
+struct tracked_object
+{
+    ~tracked_object()
+    {
+        ++destroyed_count;
+        if (this_thread::get_id() != owner_thread)
+            ++destroyed_elsewhere;
+    }
+};
+
+/**
+ * Executor which defers tasks until they are run explicitly.
+ */
+struct deferred_executor
+{
+    ~deferred_executor()
+    {
+        run_all();
+    }
+
+    void run_all()
+    {
+        while (!tasks.empty())
+        {
+            function<void()> task = std::move(tasks.front());
+            tasks.erase(tasks.begin());
+            task();
+        }
+    }
+
+    vector<function<void()>> tasks;
+};
+
+SCENARIO( "surplus objects can be destroyed asynchronously", "[object_pool]" )
+{
+    destroyed_count = 0;
+    destroyed_elsewhere = 0;
+    owner_thread = this_thread::get_id();
+
+    GIVEN( "A pool of 10 objects with a deferred reclaimer" )
+    {
+        deferred_executor executor;
+
+        carlosb::object_pool<tracked_object> pool(10);
+        pool.set_reclaimer([&executor] (function<void()> task) { executor.tasks.push_back(task); });
+
+        WHEN ( "the pool is resized with count < size()" )
+        {
+            pool.resize(4);
+
+            THEN ( "the surplus objects are handed to the reclaimer" )
+            {
+                REQUIRE( pool.size() == 4 );
+                REQUIRE( destroyed_count == 0 );
+                REQUIRE( executor.tasks.size() == 1 );
+
+                executor.run_all();
+                REQUIRE( destroyed_count == 6 );
+            }
+
+            THEN ( "the slots are reused once the objects are destroyed" )
+            {
+                size_t capacity = pool.capacity();
+                executor.run_all();
+
+                pool.resize(10);
+                REQUIRE( pool.size() == 10 );
+                REQUIRE( pool.capacity() == capacity );
+            }
+        }
+    }
+
+    GIVEN( "A pool of 10 objects with a background reclaimer" )
+    {
+        carlosb::background_reclaimer reclaimer;
+
+        THEN ( "objects are destroyed on the background thread" )
+        {
+            {
+                carlosb::object_pool<tracked_object> pool(10);
+                pool.set_reclaimer(reclaimer.executor());
+
+                pool.resize(5);
+                reclaimer.wait_idle();
+                REQUIRE( destroyed_count == 5 );
+
+                auto obj = pool.acquire();
+                REQUIRE( static_cast<bool>(obj) );
+            }
+
+            reclaimer.wait_idle();
+            REQUIRE( destroyed_count == 10 );
+            REQUIRE( destroyed_elsewhere == 10 );
+        }
+    }
+
+    GIVEN( "A pool of 10 objects without a reclaimer" )
+    {
+        THEN ( "objects are destroyed on the calling thread" )
+        {
+            {
+                carlosb::object_pool<tracked_object> pool(10);
+                pool.resize(3);
+                REQUIRE( destroyed_count == 7 );
+            }
+
+            REQUIRE( destroyed_count == 10 );
+            REQUIRE( destroyed_elsewhere == 0 );
+        }
+    }
+}
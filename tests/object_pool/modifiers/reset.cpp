@@ -0,0 +1,148 @@
+#include "catch.hpp"
+#include "object_pool.hpp"
+
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+struct record
+{
+    int     id;
+    char    payload[2048];
+};
+
+struct fragile
+{
+    static bool fail;
+
+    int     value;
+
+    fragile(int v = 0)
+        : value(v)
+    {}
+
+    fragile(const fragile& other) = default;
+
+    fragile& operator=(const fragile& other)
+    {
+        if (fail)
+            throw runtime_error("fragile::operator=()");
+        value = other.value;
+        return *this;
+    }
+};
+
+bool fragile::fail = false;
+
+SCENARIO( "objects can be reset to a prototype", "[object_pool]" )
+{
+    GIVEN( "A pool of trivially copyable records reset on release" )
+    {
+        record prototype = {};
+        prototype.id = 7;
+
+        carlosb::object_pool<record> pool(2, prototype, carlosb::reset_policy::on_release);
+        REQUIRE(pool.size() == 2);
+
+        THEN ("Released objects are reset to the prototype.")
+        {
+            {
+                auto obj = pool.acquire();
+                obj->id = 42;
+                obj->payload[100] = 'x';
+            }
+
+            auto obj1 = pool.acquire();
+            auto obj2 = pool.acquire();
+            REQUIRE(obj1->id == 7);
+            REQUIRE(obj1->payload[100] == 0);
+            REQUIRE(obj2->id == 7);
+            REQUIRE(obj2->payload[100] == 0);
+        }
+    }
+
+    GIVEN( "A pool of strings reset on acquire" )
+    {
+        carlosb::object_pool<string> pool(1, "Hello World!", carlosb::reset_policy::on_acquire);
+
+        THEN ("Objects keep their state until they are acquired again.")
+        {
+            {
+                auto obj = pool.acquire();
+                *obj = "Modified";
+            }
+
+            {
+                auto obj = pool.acquire_wait();
+                REQUIRE(*obj == "Hello World!");
+                *obj = "Modified";
+            }
+
+            {
+                auto obj = pool.allocate("Ignored");
+                REQUIRE(*obj == "Hello World!");
+            }
+        }
+
+        THEN ("Objects constructed by allocate are not reset.")
+        {
+            auto obj1 = pool.acquire();
+            auto obj2 = pool.allocate("New object");
+            REQUIRE(*obj2 == "New object");
+        }
+    }
+
+    GIVEN( "A pool of strings that are never reset" )
+    {
+        carlosb::object_pool<string> pool(1, "Hello World!", carlosb::reset_policy::never);
+
+        THEN ("Objects keep their state between uses.")
+        {
+            {
+                auto obj = pool.acquire();
+                *obj = "Modified";
+            }
+
+            auto obj = pool.acquire();
+            REQUIRE(*obj == "Modified");
+        }
+    }
+
+    GIVEN( "A pool whose objects may fail to be reset on acquire" )
+    {
+        carlosb::object_pool<fragile> pool(1, fragile(7), carlosb::reset_policy::on_acquire);
+
+        THEN ("The object returns to the pool if the reset throws.")
+        {
+            fragile::fail = true;
+            REQUIRE_THROWS_AS(pool.acquire(), runtime_error);
+            fragile::fail = false;
+
+            REQUIRE(pool.size() == 1);
+            auto obj = pool.acquire();
+            REQUIRE(obj->value == 7);
+        }
+    }
+
+    GIVEN( "A pool whose objects may fail to be reset on release" )
+    {
+        carlosb::object_pool<fragile> pool(2, fragile(7), carlosb::reset_policy::on_release);
+
+        THEN ("The object is dropped from the pool if the reset throws.")
+        {
+            {
+                auto obj = pool.acquire();
+                obj->value = 42;
+                fragile::fail = true;
+            }
+            fragile::fail = false;
+
+            REQUIRE(pool.size() == 1);
+            auto obj1 = pool.acquire();
+            auto obj2 = pool.acquire();
+            REQUIRE(obj1->value == 7);
+            REQUIRE(! static_cast<bool>(obj2));
+        }
+    }
+}
@@ -0,0 +1,56 @@
+#include "catch.hpp"
+#include "object_pool.hpp"
+
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+SCENARIO( "pools can be swapped", "[object_pool]" )
+{
+    GIVEN( "Two pools of strings" )
+    {
+        carlosb::object_pool<string> pool1(2, "first");
+
+        THEN ("Objects come from the other pool after swapping.")
+        {
+            carlosb::object_pool<string> pool2(3, "second");
+            pool1.swap(pool2);
+
+            REQUIRE(pool1.size() == 3);
+            REQUIRE(pool2.size() == 2);
+            REQUIRE(*pool1.acquire() == "second");
+            REQUIRE(*pool2.acquire() == "first");
+        }
+
+        THEN ("Leases outlive the pool swapped with.")
+        {
+            carlosb::object_pool<string>::acquired_type obj;
+            {
+                carlosb::object_pool<string> pool2(3, "second");
+                pool1.swap(pool2);
+                obj = pool1.acquire();
+            }
+            REQUIRE(*obj == "second");
+
+            obj = carlosb::none;
+            REQUIRE(pool1.size() == 3);
+            REQUIRE(! pool1.in_use());
+        }
+
+        THEN ("Pools with objects in use cannot be swapped.")
+        {
+            auto obj = pool1.acquire();
+            {
+                carlosb::object_pool<string> pool2(3, "second");
+                REQUIRE_THROWS_AS(pool1.swap(pool2), logic_error);
+                REQUIRE_THROWS_AS(pool2.swap(pool1), logic_error);
+                REQUIRE(pool2.size() == 3);
+            }
+            REQUIRE(*obj == "first");
+
+            obj = carlosb::none;
+            REQUIRE(pool1.size() == 2);
+        }
+    }
+}
@@ -0,0 +1,83 @@
+#include "catch.hpp"
+#include "object_pool.hpp"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+SCENARIO( "outstanding leases can be attributed to their call sites", "[object_pool]" )
+{
+    GIVEN ("A pool of 10 strings with site tracking enabled")
+    {
+        using acquired_object = carlosb::object_pool<string>::acquired_object;
+
+        carlosb::object_pool<string> pool(10);
+        pool.set_site_tracking(true);
+
+        vector<acquired_object> held;
+        {
+            carlosb::lease_site site("handler");
+            held.push_back(pool.acquire());
+            held.push_back(pool.acquire());
+            {
+                carlosb::lease_site inner("parser");
+                held.push_back(pool.acquire());
+            }
+            held.push_back(pool.acquire_wait());
+        }
+        held.push_back(pool.acquire());
+
+        THEN ("Leases are grouped by site, most outstanding first.")
+        {
+            vector<carlosb::site_usage> usages = pool.outstanding_by_site();
+            REQUIRE(usages.size() == 3);
+            REQUIRE(usages[0].site == "handler");
+            REQUIRE(usages[0].outstanding == 3);
+            REQUIRE(usages[1].outstanding == 1);
+            REQUIRE(usages[2].outstanding == 1);
+            REQUIRE((usages[1].site == "<unknown>" || usages[2].site == "<unknown>"));
+        }
+
+        THEN ("Returned objects are no longer reported.")
+        {
+            held.erase(held.begin(), held.begin() + 2);
+            vector<carlosb::site_usage> usages = pool.outstanding_by_site();
+            REQUIRE(usages.size() == 3);
+            REQUIRE(usages[0].outstanding == 1);
+
+            held.clear();
+            REQUIRE(pool.outstanding_by_site().empty());
+        }
+
+        THEN ("The dump lists one site per line.")
+        {
+            ostringstream os;
+            pool.dump_outstanding_by_site(os);
+            REQUIRE(os.str().find("handler: 3 outstanding, oldest ") == 0);
+            REQUIRE(os.str().find("parser: 1 outstanding") != string::npos);
+        }
+
+        THEN ("Disabling the tracking forgets the sites.")
+        {
+            pool.set_site_tracking(false);
+            REQUIRE(pool.outstanding_by_site().empty());
+
+            {
+                CARLOSB_LEASE_SITE();
+                held.push_back(pool.acquire());
+            }
+            REQUIRE(pool.outstanding_by_site().empty());
+
+            pool.set_site_tracking(true);
+            {
+                CARLOSB_LEASE_SITE();
+                held.push_back(pool.acquire());
+            }
+            vector<carlosb::site_usage> usages = pool.outstanding_by_site();
+            REQUIRE(usages.size() == 1);
+            REQUIRE(usages[0].site.find("lease_sites.cpp:") != string::npos);
+        }
+    }
+}
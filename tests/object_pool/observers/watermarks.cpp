@@ -0,0 +1,101 @@
+#include "catch.hpp"
+#include "object_pool.hpp"
+
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+SCENARIO( "callbacks are invoked when free objects cross a watermark", "[object_pool]" )
+{
+    GIVEN( "A pool of 10 ints with 5 acquired objects" )
+    {
+        using pool_type = carlosb::object_pool<int>;
+
+        pool_type pool(10, 0);
+        vector<carlosb::pool_snapshot> lows, highs;
+        vector<pool_type::acquired_type> objects;
+        for (int i = 0; i < 5; ++i)
+            objects.push_back(pool.acquire());
+
+        pool.set_watermarks(3, 8, 2,
+            [&lows] (const carlosb::pool_snapshot& s) { lows.push_back(s); },
+            [&highs] (const carlosb::pool_snapshot& s) { highs.push_back(s); });
+
+        REQUIRE( lows.empty() );
+        REQUIRE( highs.empty() );
+
+        THEN ( "the low callback is invoked once when falling below the low watermark" )
+        {
+            for (int i = 0; i < 5; ++i)
+                objects.push_back(pool.acquire());
+
+            REQUIRE( lows.size() == 1 );
+            REQUIRE( lows[0].free == 2 );
+            REQUIRE( lows[0].in_use == 8 );
+            REQUIRE( lows[0].capacity == 10 );
+        }
+
+        THEN ( "the low callback is not invoked again until the hysteresis is exceeded" )
+        {
+            for (int i = 0; i < 3; ++i)
+                objects.push_back(pool.acquire());   // 2 free
+            REQUIRE( lows.size() == 1 );
+
+            objects.pop_back();                      // 3 free
+            objects.pop_back();                      // 4 free
+            objects.push_back(pool.acquire());       // 3 free
+            objects.push_back(pool.acquire());       // 2 free
+            REQUIRE( lows.size() == 1 );
+
+            objects.pop_back();                      // 3 free
+            objects.pop_back();                      // 4 free
+            objects.pop_back();                      // 5 free, re-armed
+            objects.push_back(pool.acquire());       // 4 free
+            objects.push_back(pool.acquire());       // 3 free
+            objects.push_back(pool.acquire());       // 2 free
+            REQUIRE( lows.size() == 2 );
+        }
+
+        THEN ( "the high callback is invoked when rising above the high watermark" )
+        {
+            objects.clear();
+
+            REQUIRE( highs.size() == 1 );
+            REQUIRE( highs[0].free == 9 );
+            REQUIRE( highs[0].in_use == 1 );
+
+            pool.push(42);
+            REQUIRE( highs.size() == 1 );
+        }
+
+        THEN ( "the callbacks may use the pool" )
+        {
+            pool.set_watermarks(3, 8, 2,
+                [&pool] (const carlosb::pool_snapshot&) { pool.resize(5); },
+                pool_type::watermark_callback());
+
+            for (int i = 0; i < 3; ++i)
+                objects.push_back(pool.acquire());
+
+            REQUIRE( pool.size() == 5 );
+        }
+
+        THEN ( "the callbacks are no longer invoked after being cleared" )
+        {
+            pool.clear_watermarks();
+            objects.clear();
+            REQUIRE( highs.empty() );
+        }
+    }
+
+    GIVEN( "An empty pool" )
+    {
+        carlosb::object_pool<int> pool;
+
+        THEN ( "the low watermark may not be greater than the high watermark" )
+        {
+            REQUIRE_THROWS_AS( pool.set_watermarks(5, 4, 0, nullptr, nullptr), std::invalid_argument );
+        }
+    }
+}
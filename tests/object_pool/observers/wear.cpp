@@ -0,0 +1,73 @@
+#include "catch.hpp"
+#include "object_pool.hpp"
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+SCENARIO( "the use of every slot can be counted", "[object_pool]" )
+{
+    GIVEN ("A pool of 8 strings with wear tracking enabled")
+    {
+        carlosb::object_pool<string> pool(8);
+        pool.set_wear_tracking(true);
+
+        // LIFO reuse lends the same object every time
+        for (int i = 0; i < 5; ++i)
+        {
+            auto obj = pool.acquire();
+        }
+        {
+            auto obj1 = pool.acquire();
+            auto obj2 = pool.acquire();
+        }
+
+        THEN ("The report shows the unused slots and the reuse distribution.")
+        {
+            carlosb::wear_report report = pool.wear();
+            REQUIRE(report.slots == 8);
+            REQUIRE(report.never_used == 6);
+            REQUIRE(report.reuse.size() == 4);
+            REQUIRE(report.reuse[0] == 6);      // never lent
+            REQUIRE(report.reuse[1] == 1);      // lent once
+            REQUIRE(report.reuse[2] == 0);      // lent 2 or 3 times
+            REQUIRE(report.reuse[3] == 1);      // lent 4 to 7 times
+        }
+
+        THEN ("The hottest and coldest slots are listed.")
+        {
+            carlosb::wear_report report = pool.wear(1);
+            REQUIRE(report.hottest.size() == 1);
+            REQUIRE(report.hottest[0].acquisitions == 6);
+            REQUIRE(report.coldest.size() == 1);
+            REQUIRE(report.coldest[0].acquisitions == 1);
+            REQUIRE(report.hottest[0].slot != report.coldest[0].slot);
+        }
+
+        THEN ("Hold times accumulate when objects are returned.")
+        {
+            const void* slot = nullptr;
+            {
+                auto obj = pool.acquire();
+                slot = &*obj;
+                this_thread::sleep_for(chrono::milliseconds(5));
+            }
+
+            carlosb::wear_report report = pool.wear();
+            REQUIRE(report.hottest[0].slot == slot);
+            REQUIRE(report.hottest[0].held >= chrono::milliseconds(5));
+        }
+
+        THEN ("Disabling the tracking clears the counters.")
+        {
+            pool.set_wear_tracking(false);
+            auto obj = pool.acquire();
+
+            carlosb::wear_report report = pool.wear();
+            REQUIRE(report.never_used == 8);
+            REQUIRE(report.hottest.empty());
+        }
+    }
+}
@@ -0,0 +1,90 @@
+#include "catch.hpp"
+#include "object_pool.hpp"
+
+#include <chrono>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+SCENARIO( "the pool can grow ahead of forecast demand", "[object_pool]" )
+{
+    GIVEN( "An empty pool with a demand forecast" )
+    {
+        using pool_type = carlosb::object_pool<int>;
+
+        vector<function<void()>> tasks;
+        pool_type pool(0);
+        vector<pool_type::acquired_type> objects;
+
+        carlosb::forecast_policy policy;
+        policy.interval     = chrono::milliseconds(50);
+        policy.smoothing    = 1.0;
+        policy.headroom     = 1.0;
+        policy.max_size     = 100;
+        pool.set_forecast(policy, [&tasks] (function<void()> task) { tasks.push_back(task); });
+
+        WHEN ( "allocations miss during a window" )
+        {
+            for (int i = 0; i < 5; ++i)
+                objects.push_back(pool.allocate());
+            REQUIRE( tasks.empty() );
+
+            this_thread::sleep_for(chrono::milliseconds(60));
+            objects.push_back(pool.allocate());
+
+            THEN ( "the pool is grown by the number of misses once the window ends" )
+            {
+                REQUIRE( tasks.size() == 1 );
+                REQUIRE( pool.size() == 0 );
+
+                tasks.front()();
+                REQUIRE( pool.size() == 6 );
+                REQUIRE( pool.in_use() );
+            }
+        }
+
+        WHEN ( "the forecast exceeds the maximum size" )
+        {
+            policy.max_size = 8;
+            pool.set_forecast(policy, [&tasks] (function<void()> task) { tasks.push_back(task); });
+
+            for (int i = 0; i < 7; ++i)
+                objects.push_back(pool.allocate());
+            this_thread::sleep_for(chrono::milliseconds(60));
+            objects.push_back(pool.acquire());
+
+            THEN ( "the pool does not grow beyond it" )
+            {
+                REQUIRE( tasks.size() == 1 );
+                tasks.front()();
+                REQUIRE( pool.size() == 1 );
+            }
+        }
+
+        WHEN ( "the forecast is cleared" )
+        {
+            pool.clear_forecast();
+
+            for (int i = 0; i < 5; ++i)
+                objects.push_back(pool.allocate());
+            this_thread::sleep_for(chrono::milliseconds(60));
+            objects.push_back(pool.allocate());
+
+            THEN ( "the pool is not grown" )
+            {
+                REQUIRE( tasks.empty() );
+            }
+        }
+
+        THEN ( "invalid policies are rejected" )
+        {
+            policy.smoothing = 0.0;
+            REQUIRE_THROWS_AS( pool.set_forecast(policy, [] (function<void()>) {}), std::invalid_argument );
+            policy.smoothing = 0.5;
+            REQUIRE_THROWS_AS( pool.set_forecast(policy, nullptr), std::invalid_argument );
+        }
+    }
+}
@@ -0,0 +1,82 @@
+#include "catch.hpp"
+#include "object_pool.hpp"
+
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+struct alignas(128) over_aligned
+{
+    int value;
+};
+
+template <class T>
+static bool is_aligned(const T& obj, size_t alignment)
+{
+    return reinterpret_cast<uintptr_t>(&obj) % alignment == 0;
+}
+
+SCENARIO( "slots are aligned and padded to cache lines", "[object_pool]" )
+{
+    GIVEN( "A pool of ints using a cache aligned allocator" )
+    {
+        carlosb::object_pool<int, carlosb::cache_aligned_allocator<int>> pool(8, 42);
+        REQUIRE(pool.size() == 8);
+
+        THEN ("Every object lives in its own cache line.")
+        {
+            vector<carlosb::object_pool<int, carlosb::cache_aligned_allocator<int>>::acquired_type> objects;
+            for (int i = 0; i < 8; ++i)
+                objects.push_back(pool.acquire());
+
+            for (size_t i = 0; i < objects.size(); ++i)
+            {
+                REQUIRE(*objects[i] == 42);
+                REQUIRE(is_aligned(*objects[i], carlosb::cache_line_size));
+
+                for (size_t j = i + 1; j < objects.size(); ++j)
+                {
+                    uintptr_t a = reinterpret_cast<uintptr_t>(&*objects[i]);
+                    uintptr_t b = reinterpret_cast<uintptr_t>(&*objects[j]);
+                    REQUIRE((a > b ? a - b : b - a) >= carlosb::cache_line_size);
+                }
+            }
+        }
+
+        THEN ("Objects pushed after growing are aligned as well.")
+        {
+            for (int i = 0; i < 20; ++i)
+                pool.push(i);
+
+            REQUIRE(pool.size() == 28);
+            vector<carlosb::object_pool<int, carlosb::cache_aligned_allocator<int>>::acquired_type> objects;
+            while (auto obj = pool.acquire())
+            {
+                REQUIRE(is_aligned(*obj, carlosb::cache_line_size));
+                objects.push_back(std::move(obj));
+            }
+            REQUIRE(objects.size() == 28);
+        }
+    }
+
+    GIVEN( "A pool of over-aligned objects using the default allocator" )
+    {
+        carlosb::object_pool<over_aligned> pool;
+
+        THEN ("Every object respects the alignment of the type.")
+        {
+            for (int i = 0; i < 10; ++i)
+                pool.emplace();
+
+            REQUIRE(pool.size() == 10);
+            vector<carlosb::object_pool<over_aligned>::acquired_type> objects;
+            while (auto obj = pool.acquire())
+            {
+                REQUIRE(is_aligned(*obj, alignof(over_aligned)));
+                objects.push_back(std::move(obj));
+            }
+            REQUIRE(objects.size() == 10);
+        }
+    }
+}
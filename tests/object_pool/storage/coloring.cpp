@@ -0,0 +1,89 @@
+#include "catch.hpp"
+#include "object_pool.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+using namespace std;
+
+struct page_sized_record
+{
+    char data[4096];
+};
+
+template <class T, size_t Colors>
+struct page_allocator
+{
+    using value_type    = T;
+    using size_type     = size_t;
+
+    static constexpr size_t slot_alignment = 64;
+    static constexpr size_t slab_colors    = Colors;
+
+    T* allocate(size_type n)
+    {
+        void* ptr = nullptr;
+        if (posix_memalign(&ptr, 4096, n * sizeof(T)) != 0)
+            throw bad_alloc();
+        return static_cast<T*>(ptr);
+    }
+
+    void deallocate(T* ptr, size_type)
+    {
+        free(ptr);
+    }
+};
+
+template <class Pool>
+static vector<uintptr_t> page_offsets(Pool& pool)
+{
+    vector<typename Pool::acquired_type> objects;
+    vector<uintptr_t> offsets;
+    while (auto obj = pool.acquire())
+    {
+        offsets.push_back(reinterpret_cast<uintptr_t>(&*obj) % 4096);
+        objects.push_back(std::move(obj));
+    }
+    sort(offsets.begin(), offsets.end());
+    return offsets;
+}
+
+SCENARIO( "slabs are colored to reduce cache conflicts", "[object_pool]" )
+{
+    GIVEN( "A pool of page sized records with 4 slab colors" )
+    {
+        carlosb::object_pool<page_sized_record, page_allocator<page_sized_record, 4>> pool;
+
+        // one slab of 4 slots followed by three slabs of a single slot
+        pool.reserve(5);
+        pool.reserve(6);
+        pool.reserve(7);
+        for (int i = 0; i < 7; ++i)
+            pool.emplace();
+
+        THEN ("The first slot of each slab starts at a different cache line.")
+        {
+            vector<uintptr_t> expected = { 0, 0, 0, 0, 64, 128, 192 };
+            REQUIRE(page_offsets(pool) == expected);
+        }
+    }
+
+    GIVEN( "A pool of page sized records without colors" )
+    {
+        carlosb::object_pool<page_sized_record, page_allocator<page_sized_record, 1>> pool;
+
+        pool.reserve(5);
+        pool.reserve(6);
+        pool.reserve(7);
+        for (int i = 0; i < 7; ++i)
+            pool.emplace();
+
+        THEN ("Every slot starts at the beginning of a page.")
+        {
+            vector<uintptr_t> expected(7, 0);
+            REQUIRE(page_offsets(pool) == expected);
+        }
+    }
+}
@@ -0,0 +1,67 @@
+#include "catch.hpp"
+#include "object_pool.hpp"
+
+#include <memory>
+#include <string>
+
+using namespace std;
+
+static size_t allocations   = 0;
+static size_t deallocations = 0;
+
+template <class T>
+struct counting_allocator
+{
+    using value_type    = T;
+    using size_type     = size_t;
+
+    T* allocate(size_type n)
+    {
+        ++allocations;
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* ptr, size_type n)
+    {
+        ++deallocations;
+        std::allocator<T>().deallocate(ptr, n);
+    }
+};
+
+SCENARIO( "the pool frees its storage a slab at a time", "[object_pool]" )
+{
+    allocations = 0;
+    deallocations = 0;
+
+    GIVEN( "A pool of 100000 ints grown in a few steps" )
+    {
+        {
+            carlosb::object_pool<int, counting_allocator<int>> pool(100000);
+            pool.resize(150000);
+            for (int i = 0; i < 1000; ++i)
+                pool.push(i);
+
+            REQUIRE( pool.size() == 151000 );
+        }
+
+        THEN ( "every slab is released with a single deallocation" )
+        {
+            REQUIRE( allocations == 3 );
+            REQUIRE( deallocations == allocations );
+        }
+    }
+
+    GIVEN( "A pool of strings" )
+    {
+        {
+            carlosb::object_pool<string, counting_allocator<string>> pool(1000, "Hello World!");
+            pool.emplace("Last one");
+        }
+
+        THEN ( "every slab is released with a single deallocation" )
+        {
+            REQUIRE( allocations == 2 );
+            REQUIRE( deallocations == allocations );
+        }
+    }
+}
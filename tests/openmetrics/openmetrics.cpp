@@ -0,0 +1,110 @@
+#include "catch.hpp"
+#include "openmetrics.hpp"
+
+#include <string>
+#include <sstream>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+
+using namespace std;
+
+SCENARIO( "pool counters can be written in the OpenMetrics format", "[openmetrics]" )
+{
+    GIVEN( "A pool of 2 strings which has been used" )
+    {
+        carlosb::object_pool<string> pool(2, "Hello World!");
+        {
+            auto obj1 = pool.acquire();
+            auto obj2 = pool.acquire();
+            auto obj3 = pool.acquire();
+        }
+
+        THEN ("The counters track the use of the pool.")
+        {
+            carlosb::pool_metrics m = pool.metrics();
+            REQUIRE(m.acquisitions == 3);
+            REQUIRE(m.misses == 1);
+            REQUIRE(m.releases == 2);
+            REQUIRE(m.free == 2);
+            REQUIRE(m.in_use == 0);
+            REQUIRE(m.capacity == 2);
+
+            auto obj = pool.acquire();
+            REQUIRE(pool.metrics().in_use == 1);
+        }
+
+        THEN ("Waits are counted in the wait histogram.")
+        {
+            auto obj1 = pool.acquire();
+            auto obj2 = pool.acquire();
+            REQUIRE(! static_cast<bool>(pool.acquire_wait(chrono::milliseconds(20))));
+
+            carlosb::pool_metrics m = pool.metrics();
+            REQUIRE(m.waits == 1);
+            REQUIRE(m.wait_seconds >= 0.019);
+            REQUIRE(m.wait_buckets[3] == 1);    // up to 0.1s
+        }
+
+        THEN ("The wait histogram is read as a whole while waits are counted.")
+        {
+            auto obj1 = pool.acquire();
+            auto obj2 = pool.acquire();
+
+            atomic<bool> done(false);
+            thread waiter([&pool, &done]()
+            {
+                for (int i = 0; i < 200; ++i)
+                    pool.acquire_wait(chrono::milliseconds(1));
+                done = true;
+            });
+
+            bool consistent = true;
+            while (!done)
+            {
+                carlosb::pool_metrics m = pool.metrics();
+                uint64_t bucketed = 0;
+                for (size_t i = 0; i < carlosb::pool_metrics::wait_bucket_count; ++i)
+                    bucketed += m.wait_buckets[i];
+                consistent = consistent && bucketed == m.waits;
+            }
+            waiter.join();
+
+            REQUIRE(consistent);
+            REQUIRE(pool.metrics().waits == 200);
+        }
+
+        THEN ("The exposition labels the samples with the pool name.")
+        {
+            ostringstream os;
+            carlosb::write_openmetrics(os, "strings", pool);
+            string text = os.str();
+
+            REQUIRE(text.find("# TYPE object_pool_acquisitions counter\n") != string::npos);
+            REQUIRE(text.find("object_pool_acquisitions_total{pool=\"strings\"} 3\n") != string::npos);
+            REQUIRE(text.find("object_pool_misses_total{pool=\"strings\"} 1\n") != string::npos);
+            REQUIRE(text.find("object_pool_free{pool=\"strings\"} 2\n") != string::npos);
+            REQUIRE(text.find("object_pool_wait_seconds_bucket{pool=\"strings\",le=\"0.001\"} 0\n") != string::npos);
+            REQUIRE(text.find("object_pool_wait_seconds_bucket{pool=\"strings\",le=\"10.0\"} 0\n") != string::npos);
+            REQUIRE(text.find("object_pool_wait_seconds_bucket{pool=\"strings\",le=\"+Inf\"} 0\n") != string::npos);
+            REQUIRE(text.find("object_pool_wait_seconds_count{pool=\"strings\"} 0\n") != string::npos);
+            REQUIRE(text.substr(text.size() - 6) == "# EOF\n");
+        }
+
+        THEN ("A registry writes every registered pool at once.")
+        {
+            carlosb::metrics_registry registry;
+            carlosb::object_pool<int> other(5);
+            registry.add("strings", pool);
+            registry.add("quoted \"ints\"", other);
+
+            string text = registry.scrape();
+            REQUIRE(text.find("object_pool_capacity{pool=\"strings\"} 2\n") != string::npos);
+            REQUIRE(text.find("object_pool_capacity{pool=\"quoted \\\"ints\\\"\"} 5\n") != string::npos);
+            REQUIRE(text.find("# TYPE object_pool_capacity gauge\n") == text.rfind("# TYPE object_pool_capacity gauge\n"));
+
+            registry.remove("strings");
+            REQUIRE(registry.scrape().find("pool=\"strings\"") == string::npos);
+        }
+    }
+}
@@ -0,0 +1,122 @@
+#include "catch.hpp"
+#include "poly_object_pool.hpp"
+
+#include <string>
+
+using namespace std;
+
+namespace
+{
+    struct message
+    {
+        virtual ~message() {}
+        virtual string name() const = 0;
+    };
+
+    struct ping : message
+    {
+        explicit ping(int seq = 0) : seq(seq) {}
+        string name() const override { return "ping"; }
+        int seq;
+    };
+
+    struct text : message
+    {
+        explicit text(string body) : body(std::move(body)) {}
+        string name() const override { return "text"; }
+        string body;
+    };
+}
+
+SCENARIO( "a polymorphic pool lends objects of any derived type", "[poly_object_pool]" )
+{
+    GIVEN( "A pool of messages" )
+    {
+        carlosb::poly_object_pool<message, 64> pool;
+
+        THEN ("Objects of different types share the pool.")
+        {
+            auto obj1 = pool.emplace<ping>(1);
+            auto obj2 = pool.emplace<text>("Hello World!");
+
+            REQUIRE(obj1->seq == 1);
+            REQUIRE(obj2->body == "Hello World!");
+            REQUIRE(obj1->name() == "ping");
+            REQUIRE(obj2->name() == "text");
+            REQUIRE(pool.capacity() >= 2);
+            REQUIRE(pool.in_use());
+        }
+
+        THEN ("Released objects are reused for their own type.")
+        {
+            pool.reserve(2);
+
+            ping* released = nullptr;
+            {
+                auto obj = pool.emplace<ping>(1);
+                released = &*obj;
+            }
+            REQUIRE(pool.size() == 1);
+            REQUIRE(pool.size<ping>() == 1);
+            REQUIRE(pool.size<text>() == 0);
+            REQUIRE(! pool.in_use());
+
+            auto obj1 = pool.emplace<text>("Hello World!");
+            REQUIRE(static_cast<void*>(&*obj1) != static_cast<void*>(released));
+
+            auto obj2 = pool.emplace<ping>(2);
+            REQUIRE(&*obj2 == released);
+            REQUIRE(obj2->seq == 1);
+        }
+
+        THEN ("Free objects of another type give up their slot before the pool grows.")
+        {
+            void* released = nullptr;
+            {
+                auto obj1 = pool.emplace<ping>(1);
+                auto obj2 = pool.emplace<ping>(2);
+                released = &*obj1;  // released last
+            }
+            REQUIRE(pool.capacity() == 2);
+            REQUIRE(pool.size<ping>() == 2);
+
+            auto obj3 = pool.emplace<text>("Hello World!");
+            auto obj4 = pool.emplace<text>("Hello Again!");
+            REQUIRE(static_cast<void*>(&*obj3) == released);
+            REQUIRE(obj4->body == "Hello Again!");
+            REQUIRE(pool.capacity() == 2);
+            REQUIRE(pool.size<ping>() == 0);
+            REQUIRE(pool.empty());
+
+            auto obj5 = pool.emplace<ping>(5);
+            REQUIRE(obj5->seq == 5);
+            REQUIRE(pool.capacity() > 2);
+        }
+
+        THEN ("Only free objects are acquired.")
+        {
+            REQUIRE(! static_cast<bool>(pool.acquire<ping>()));
+
+            pool.emplace<ping>(1);
+            auto obj = pool.acquire<ping>();
+            REQUIRE(static_cast<bool>(obj));
+            REQUIRE(! static_cast<bool>(pool.acquire<ping>()));
+        }
+
+        THEN ("Objects acquired as a derived type can be held as the base type.")
+        {
+            {
+                carlosb::poly_object_pool<message, 64>::acquired_object<> obj = pool.emplace<text>("Hello World!");
+                REQUIRE(obj->name() == "text");
+            }
+            REQUIRE(pool.size<text>() == 1);
+        }
+
+        THEN ("We can reserve slots.")
+        {
+            pool.reserve(8);
+            REQUIRE(pool.capacity() == 8);
+            REQUIRE(pool.empty());
+        }
+    }
+}
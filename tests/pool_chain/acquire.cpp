@@ -0,0 +1,77 @@
+#include "catch.hpp"
+#include "pool_chain.hpp"
+
+#include <string>
+#include <thread>
+#include <chrono>
+
+using namespace std;
+
+SCENARIO( "acquisitions fall back along a chain of pools", "[pool_chain]" )
+{
+    GIVEN( "A chain of a pool of 1 and a pool of 2 strings" )
+    {
+        carlosb::object_pool<string> local(1, "Local");
+        carlosb::object_pool<string> shared(2, "Shared");
+        carlosb::pool_chain<string> chain{local, shared};
+
+        REQUIRE(chain.size() == 2);
+
+        THEN ("Objects are acquired from the preferred pool first.")
+        {
+            auto obj1 = chain.acquire();
+            auto obj2 = chain.acquire();
+            auto obj3 = chain.acquire();
+            auto obj4 = chain.acquire();
+
+            REQUIRE(*obj1 == "Local");
+            REQUIRE(*obj2 == "Shared");
+            REQUIRE(*obj3 == "Shared");
+            REQUIRE(! static_cast<bool>(obj4));
+        }
+
+        THEN ("Objects return to the pool they were acquired from.")
+        {
+            {
+                auto obj1 = chain.acquire();
+                auto obj2 = chain.acquire();
+                REQUIRE(local.empty());
+                REQUIRE(shared.size() == 1);
+            }
+            REQUIRE(local.size() == 1);
+            REQUIRE(shared.size() == 2);
+        }
+
+        THEN ("We can wait on the last pool.")
+        {
+            auto obj1 = chain.acquire();
+            auto obj2 = chain.acquire();
+            auto obj3 = chain.acquire();
+
+            auto obj4 = chain.acquire_wait(chrono::milliseconds(10));
+            REQUIRE(! static_cast<bool>(obj4));
+
+            thread t([&obj3]()
+            {
+                this_thread::sleep_for(chrono::milliseconds(50));
+                obj3 = carlosb::none;
+            });
+
+            obj4 = chain.acquire_wait();
+            t.join();
+            REQUIRE(*obj4 == "Shared");
+        }
+    }
+
+    GIVEN( "An empty chain" )
+    {
+        carlosb::pool_chain<string> chain;
+
+        THEN ("Nothing is acquired.")
+        {
+            REQUIRE(chain.empty());
+            REQUIRE(! static_cast<bool>(chain.acquire()));
+            REQUIRE(! static_cast<bool>(chain.acquire_wait(chrono::milliseconds(1))));
+        }
+    }
+}
@@ -0,0 +1,102 @@
+#include "catch.hpp"
+#include "pooled_executor.hpp"
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+SCENARIO( "tasks run with contexts borrowed from a pool", "[pooled_executor]" )
+{
+    GIVEN( "A pool of 2 contexts and an executor of 2 workers" )
+    {
+        carlosb::object_pool<string> contexts(2, "context");
+
+        THEN ("Every task runs with a context.")
+        {
+            atomic<int> runs(0);
+            {
+                carlosb::pooled_executor<string> executor(contexts, 2);
+                REQUIRE(executor.workers() == 2);
+
+                for (int i = 0; i < 1000; ++i)
+                {
+                    executor.submit([&runs] (string& context)
+                    {
+                        if (context == "context")
+                            ++runs;
+                    });
+                }
+            }
+            REQUIRE(runs.load() == 1000);
+            REQUIRE(contexts.size() == 2);
+        }
+
+        THEN ("Contexts are reused and return to the pool when idle.")
+        {
+            mutex seen_mutex;
+            set<const string*> seen;
+
+            carlosb::pooled_executor<string> executor(contexts, 2);
+            for (int i = 0; i < 1000; ++i)
+            {
+                executor.submit([&seen_mutex, &seen] (string& context)
+                {
+                    lock_guard<mutex> lock(seen_mutex);
+                    seen.insert(&context);
+                });
+            }
+            executor.wait_idle();
+
+            REQUIRE(seen.size() <= 2);
+            REQUIRE(contexts.size() == 2);
+            REQUIRE(contexts.capacity() == 2);
+            REQUIRE(! contexts.in_use());
+        }
+
+        THEN ("Workers get their own context back after idling.")
+        {
+            mutex seen_mutex;
+            map<thread::id, set<const string*>> seen;
+
+            carlosb::pooled_executor<string> executor(contexts, 2);
+            for (int round = 0; round < 20; ++round)
+            {
+                for (int i = 0; i < 50; ++i)
+                {
+                    executor.submit([&seen_mutex, &seen] (string& context)
+                    {
+                        lock_guard<mutex> lock(seen_mutex);
+                        seen[this_thread::get_id()].insert(&context);
+                    });
+                }
+                executor.wait_idle();
+            }
+
+            for (auto& worker : seen)
+                REQUIRE(worker.second.size() == 1);
+            REQUIRE(contexts.size() == 2);
+        }
+
+        THEN ("Workers wait for a context held elsewhere.")
+        {
+            auto held = contexts.acquire();
+            auto held2 = contexts.acquire();
+
+            atomic<int> runs(0);
+            carlosb::pooled_executor<string> executor(contexts, 2);
+            executor.submit([&runs] (string&) { ++runs; });
+
+            this_thread::sleep_for(chrono::milliseconds(20));
+            REQUIRE(runs.load() == 0);
+
+            held = carlosb::none;
+            executor.wait_idle();
+            REQUIRE(runs.load() == 1);
+        }
+    }
+}
@@ -0,0 +1,69 @@
+#include "catch.hpp"
+#include "shm_stats.hpp"
+
+#include <string>
+#include <unistd.h>
+
+using namespace std;
+
+SCENARIO( "pool counters can be published to shared memory", "[shm_stats]" )
+{
+    GIVEN( "A stats page and a pool of 2 strings attached to it" )
+    {
+        string page_name = "/object_pool.test." + to_string(::getpid());
+        carlosb::shm_stats_page page(page_name);
+        carlosb::object_pool<string> pool(2, "Hello World!");
+        page.attach("strings", pool);
+
+        carlosb::shm_stats_reader reader(page_name);
+
+        THEN ("The reader sees the counters of the pool.")
+        {
+            auto obj1 = pool.acquire();
+            auto obj2 = pool.acquire();
+            auto obj3 = pool.acquire();
+
+            carlosb::named_metrics pools = reader.read();
+            REQUIRE(pools.size() == 1);
+            REQUIRE(pools[0].first == "strings");
+            REQUIRE(pools[0].second.acquisitions == 3);
+            REQUIRE(pools[0].second.misses == 1);
+            REQUIRE(pools[0].second.free == 0);
+            REQUIRE(pools[0].second.in_use == 2);
+            REQUIRE(pools[0].second.capacity == 2);
+        }
+
+        THEN ("Releases are published too.")
+        {
+            {
+                auto obj = pool.acquire();
+            }
+            carlosb::pool_metrics m = reader.read().at(0).second;
+            REQUIRE(m.releases == 1);
+            REQUIRE(m.free == 2);
+            REQUIRE(m.in_use == 0);
+        }
+
+        THEN ("Detached pools are no longer listed.")
+        {
+            carlosb::object_pool<int> other(5);
+            page.attach("ints", other);
+            REQUIRE(reader.read().size() == 2);
+
+            page.detach("strings");
+            carlosb::named_metrics pools = reader.read();
+            REQUIRE(pools.size() == 1);
+            REQUIRE(pools[0].first == "ints");
+            REQUIRE(pools[0].second.free == 5);
+
+            // the pool stops writing to its former entry
+            auto obj = pool.acquire();
+            REQUIRE(reader.read().size() == 1);
+        }
+
+        THEN ("Missing pages are rejected.")
+        {
+            REQUIRE_THROWS_AS(carlosb::shm_stats_reader(page_name + ".missing"), std::system_error);
+        }
+    }
+}
@@ -0,0 +1,81 @@
+#include "catch.hpp"
+#include "slot_map.hpp"
+
+#include <string>
+#include <algorithm>
+
+using namespace std;
+
+SCENARIO( "values of a slot map are addressed by stable keys", "[slot_map]" )
+{
+    GIVEN( "A slot map of 3 strings" )
+    {
+        carlosb::slot_map<string> map;
+        auto a = map.insert("a");
+        auto b = map.insert("b");
+        auto c = map.emplace(1, 'c');
+
+        REQUIRE(map.size() == 3);
+
+        THEN ("Values are found by their keys.")
+        {
+            REQUIRE(*map.find(a) == "a");
+            REQUIRE(map.at(b) == "b");
+            REQUIRE(map.at(c) == "c");
+        }
+
+        THEN ("Keys survive the erasure of other values.")
+        {
+            REQUIRE(map.erase(a));
+            REQUIRE(map.size() == 2);
+            REQUIRE(map.at(b) == "b");
+            REQUIRE(map.at(c) == "c");
+        }
+
+        THEN ("Keys to erased values are stale.")
+        {
+            REQUIRE(map.erase(b));
+            REQUIRE(! map.contains(b));
+            REQUIRE(map.find(b) == nullptr);
+            REQUIRE_THROWS_AS(map.at(b), std::out_of_range);
+            REQUIRE(! map.erase(b));
+
+            // the slot is reused, but not the key
+            auto d = map.insert("d");
+            REQUIRE(d.index == b.index);
+            REQUIRE(d != b);
+            REQUIRE(! map.contains(b));
+            REQUIRE(map.at(d) == "d");
+        }
+
+        THEN ("Values are densely packed.")
+        {
+            map.erase(a);
+            REQUIRE(map.end() - map.begin() == 2);
+            REQUIRE(count(map.begin(), map.end(), "b") == 1);
+            REQUIRE(count(map.begin(), map.end(), "c") == 1);
+
+            for (size_t i = 0; i < map.size(); ++i)
+                REQUIRE(map.at(map.key_of(i)) == *(map.begin() + i));
+        }
+
+        THEN ("Clearing makes every key stale.")
+        {
+            map.clear();
+            REQUIRE(map.empty());
+            REQUIRE(! map.contains(a));
+            REQUIRE(! map.contains(b));
+            REQUIRE(! map.contains(c));
+
+            auto d = map.insert("d");
+            auto e = map.insert("e");
+            auto f = map.insert("f");
+            auto g = map.insert("g");
+            REQUIRE(map.at(d) == "d");
+            REQUIRE(map.at(e) == "e");
+            REQUIRE(map.at(f) == "f");
+            REQUIRE(map.at(g) == "g");
+            REQUIRE(map.size() == 4);
+        }
+    }
+}
@@ -0,0 +1,89 @@
+/**
+ * Prints the counters of every pool a running process publishes to its
+ * `shm_stats_page`, without stopping or attaching to the process.
+ *
+ * Usage:
+ * g++ -std=c++11 -O2 -Isrc tools/pool_stats.cpp -o pool_stats
+ * ./pool_stats <pid> [interval in seconds] [--openmetrics]
+ *
+ * Without an interval, the counters are printed once. With
+ * `--openmetrics`, they are printed in the OpenMetrics text format.
+ */
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include "shm_stats.hpp"
+
+using namespace std;
+using namespace carlosb;
+
+void print_table(const named_metrics& pools)
+{
+    cout << left << setw(24) << "pool"
+         << right << setw(10) << "free"
+         << setw(10) << "in_use"
+         << setw(10) << "capacity"
+         << setw(14) << "acquisitions"
+         << setw(10) << "misses"
+         << setw(10) << "waits"
+         << setw(12) << "wait_s" << '\n';
+
+    for (const pair<string, pool_metrics>& pool : pools)
+    {
+        const pool_metrics& m = pool.second;
+        cout << left << setw(24) << pool.first
+             << right << setw(10) << m.free
+             << setw(10) << m.in_use
+             << setw(10) << m.capacity
+             << setw(14) << m.acquisitions
+             << setw(10) << m.misses
+             << setw(10) << m.waits
+             << setw(12) << fixed << setprecision(3) << m.wait_seconds << '\n';
+    }
+    cout << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    bool openmetrics = false;
+    double interval = 0;
+    int pid = 0;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--openmetrics") == 0)
+            openmetrics = true;
+        else if (pid == 0)
+            pid = atoi(argv[i]);
+        else
+            interval = atof(argv[i]);
+    }
+
+    if (pid <= 0)
+    {
+        cerr << "usage: " << argv[0] << " <pid> [interval in seconds] [--openmetrics]" << endl;
+        return 2;
+    }
+
+    try
+    {
+        shm_stats_reader reader(shm_stats_page::default_name(pid));
+        do
+        {
+            if (openmetrics)
+                write_openmetrics(cout, reader.read());
+            else
+                print_table(reader.read());
+
+            this_thread::sleep_for(chrono::duration<double>(interval));
+        } while (interval > 0);
+    }
+    catch (const exception& e)
+    {
+        cerr << argv[0] << ": " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}